@@ -8,12 +8,18 @@
 #include "../Support/Platforms/Platforms.h"
 #include "../Support/Memory Management/Allocation.h"
 #include "../Support/Collections/Vector.h"
+#include "../Support/Collections/ArrayView.h"
 #include "../Support/Matrix.h"
 #include "../Support/DateTime/DateTime.h"
 #include "../Support/IO/EndianBinaryReader.h"
 #include "../Support/Text/StringComparison.h"
 #include "../Support/Parsing/Xml/XmlParser.h"
 #include "../Support/IO/Streams.h"
+#include "../Support/IO/FileStream.h"
+#include "../Support/IO/BufferedStream.h"
+#include "../Support/IO/MappedFileStream.h"
+#include "../Support/IO/BufferViewStream.h"
+#include "../Support/IO/SharedFileStream.h"
 #include "../Dml.h"
 
 namespace wb
@@ -24,12 +30,183 @@ namespace wb
 		using namespace wb::io;
 		using namespace wb::memory;
 
+		/// <summary>
+		/// DmlVisitor provides empty handlers for every kind of node delivered by DmlReader::Accept().  A visitor derives from
+		/// DmlVisitor and declares only the handlers it needs, with the same signatures; they hide the empty ones.  Accept() is a 
+		/// template over the visitor type, so the handlers are resolved at compile time and can be inlined.  None of the 
+		/// handlers are virtual.
+		/// </summary>
+		/// <remarks>
+		/// The Association identifies the node by DMLID and name and remains valid only for the duration of the handler call, 
+		/// as do the string, array, and matrix arguments.  Arrays and matrices are presented in place when the stream permits
+		/// (see DmlReader::CanGetView()) and otherwise from a buffer reused for each node.
+		/// </remarks>
+		class DmlVisitor
+		{
+		public:
+			void OnContainer(const Association& /*Node*/) { }
+			void OnEndAttributes() { }
+			void OnEndContainer(const Association& /*Container*/) { }
+			void OnComment(const string& /*Text*/) { }
+
+			void OnUInt(const Association& /*Node*/, UInt64 /*Value*/) { }
+			void OnInt(const Association& /*Node*/, Int64 /*Value*/) { }
+			void OnBoolean(const Association& /*Node*/, bool /*Value*/) { }
+			void OnString(const Association& /*Node*/, const string& /*Value*/) { }
+			void OnDateTime(const Association& /*Node*/, const DateTime& /*Value*/) { }
+			void OnSingle(const Association& /*Node*/, float /*Value*/) { }
+			void OnDouble(const Association& /*Node*/, double /*Value*/) { }
+
+			void OnByteArray(const Association& /*Node*/, const array_view<byte>& /*Value*/) { }
+			void OnUInt16Array(const Association& /*Node*/, const array_view<UInt16>& /*Value*/) { }
+			void OnUInt32Array(const Association& /*Node*/, const array_view<UInt32>& /*Value*/) { }
+			void OnUInt64Array(const Association& /*Node*/, const array_view<UInt64>& /*Value*/) { }
+			void OnInt8Array(const Association& /*Node*/, const array_view<char>& /*Value*/) { }
+			void OnInt16Array(const Association& /*Node*/, const array_view<Int16>& /*Value*/) { }
+			void OnInt32Array(const Association& /*Node*/, const array_view<Int32>& /*Value*/) { }
+			void OnInt64Array(const Association& /*Node*/, const array_view<Int64>& /*Value*/) { }
+			void OnSingleArray(const Association& /*Node*/, const array_view<float>& /*Value*/) { }
+			void OnDoubleArray(const Association& /*Node*/, const array_view<double>& /*Value*/) { }
+			void OnDateTimeArray(const Association& /*Node*/, const vector<DateTime>& /*Value*/) { }
+			void OnStringArray(const Association& /*Node*/, const vector<string>& /*Value*/) { }
+
+			void OnUInt8Matrix(const Association& /*Node*/, const matrix_view<UInt8>& /*Value*/) { }
+			void OnUInt16Matrix(const Association& /*Node*/, const matrix_view<UInt16>& /*Value*/) { }
+			void OnUInt32Matrix(const Association& /*Node*/, const matrix_view<UInt32>& /*Value*/) { }
+			void OnUInt64Matrix(const Association& /*Node*/, const matrix_view<UInt64>& /*Value*/) { }
+			void OnInt8Matrix(const Association& /*Node*/, const matrix_view<char>& /*Value*/) { }
+			void OnInt16Matrix(const Association& /*Node*/, const matrix_view<Int16>& /*Value*/) { }
+			void OnInt32Matrix(const Association& /*Node*/, const matrix_view<Int32>& /*Value*/) { }
+			void OnInt64Matrix(const Association& /*Node*/, const matrix_view<Int64>& /*Value*/) { }
+			void OnSingleMatrix(const Association& /*Node*/, const matrix_view<float>& /*Value*/) { }
+			void OnDoubleMatrix(const Association& /*Node*/, const matrix_view<double>& /*Value*/) { }
+		};
+
 		class DmlReader
 		{
 			#pragma region "Internal Parsing"
 
 			r_ptr<BinaryReader>	m_pReader;
 
+			/// <summary>Scratch buffer for discarding content from streams that cannot seek.  Allocated on first use.</summary>
+			memory::Buffer		m_Scratch;
+
+			/// <summary>Element count of the open array node, when it has already been read from the stream by GetArrayLength().
+			/// Valid only while m_HasArrayLength is true.</summary>
+			UInt64				m_ArrayLength;
+			bool				m_HasArrayLength;
+
+			/// <summary>Returns the element count of the open array node, reading it from the stream if it has not been read 
+			/// already.  The count remains available to the next PeekArrayLength() or ReadArrayLength() call.</summary>
+			UInt64 PeekArrayLength()
+			{
+				if (!m_HasArrayLength) { m_ArrayLength = m_pReader->ReadCompact64(); m_HasArrayLength = true; }
+				return m_ArrayLength;
+			}
+
+			/// <summary>Called with the value of each UInt node as it is retrieved, to record a DML:ContentSize attribute in the
+			/// current container.</summary>
+			void NoteUInt(UInt64 Value)
+			{
+				if (m_pAssociation->DMLID == dmltsl::dml3::idDMLContentSize && IsAttribute && m_pContainer != nullptr) m_pContainer->ContentSize = Value;
+			}
+
+			/// <summary>Returns the element count of the open array node, which is consumed, leaving the stream positioned at the
+			/// array content.</summary>
+			UInt64 ReadArrayLength()
+			{
+				UInt64 Elements = PeekArrayLength();
+				m_HasArrayLength = false;
+				return Elements;
+			}
+
+			/** Inline Identification **/
+
+			/// <summary>Associations created for inline identification, keyed by the raw name and type read from the stream, so that
+			/// a repeated inline identification resolves to the same Association without parsing or allocation.  The reader owns
+			/// these Associations.  At most MaxInlineAssociations are kept, so that a stream of distinct names cannot grow the table
+			/// without bound; associations beyond the limit are created for each node as needed.</summary>
+			typedef unordered_map<string, Association*> inline_map_type;
+			inline_map_type		m_InlineAssociations;
+			string				m_InlineKey;
+			static const size_t MaxInlineAssociations = 4096;
+
+			/** Access Hints **/
+
+			/// <summary>Data more than ReleaseBehindSize bytes behind a sequential scan is released from the cache.  WillNeedSize bytes
+			/// are requested ahead of a seek target.</summary>
+			static const Int64 ReleaseBehindSize = 64 * 1048576;
+			static const Int64 WillNeedSize = 1048576;
+
+			// The position before which the stream has been told that data is no longer needed.  Int64_MaxValue until the first
+			// Read() has issued hints, or -1 if hints are not in use.
+			Int64 m_ReleasedThrough;
+			bool m_AdvisedSequential;
+
+			/// <summary>Called at each Read().  Advises sequential access on the first call and releases data left behind by a long
+			/// scan.</summary>
+			void AdviseScan()
+			{
+				if (m_ReleasedThrough < 0) return;
+				if (m_ReleasedThrough == Int64_MaxValue)
+				{
+					if (!m_pReader->m_pStream->CanSeek()) { m_ReleasedThrough = -1; return; }
+					m_pReader->m_pStream->AdviseAccess(AccessPattern::Sequential);
+					m_AdvisedSequential = true;
+					m_ReleasedThrough = m_pReader->GetPosition();
+					return;
+				}
+				Int64 Position = m_pReader->GetPosition();
+				if (Position - m_ReleasedThrough < ReleaseBehindSize) return;
+				m_pReader->m_pStream->AdviseDontNeed(m_ReleasedThrough, Position - m_ReleasedThrough);
+				m_ReleasedThrough = Position;
+			}
+
+			/// <summary>Called when navigation seeks to Position.  The stream is no longer read sequentially, so the sequential advice
+			/// is withdrawn and the data at the target is requested instead.</summary>
+			void AdviseSeek(Int64 Position)
+			{
+				if (!Options.AccessHints || m_ReleasedThrough < 0) return;
+				if (m_AdvisedSequential) { m_pReader->m_pStream->AdviseAccess(AccessPattern::Normal); m_AdvisedSequential = false; }
+				m_pReader->m_pStream->AdviseWillNeed(Position, WillNeedSize);
+				if (m_ReleasedThrough != Int64_MaxValue) m_ReleasedThrough = Position;
+			}
+
+			/** Status of Try..() Calls **/
+
+			// The outcome of the most recent unsuccessful Try..() call.  The message is a string literal, and the error context is
+			// assembled only if GetStatusMessage() is called, so that an expected failure neither allocates nor throws.
+			ReadStatus		m_Status;
+			const char*		m_pStatusMessage;
+			UInt32			m_StatusID;
+
+			ReadStatus Fail(ReadStatus Status, const char* pszMessage)
+			{
+				m_Status = Status;
+				m_pStatusMessage = pszMessage;
+				return Status;
+			}
+
+			/// <summary>Verifies that a primitive of the Expected type is open for reading.</summary>
+			ReadStatus CheckPrimitive(PrimitiveTypes Expected)
+			{
+				if (!IsNodeOpen()) return Fail(ReadStatus::NotOpen, "No node is currently open for reading.");
+				if (m_pAssociation->NodeType != NodeTypes::Primitive || m_pAssociation->PrimitiveType != Expected)
+					return Fail(ReadStatus::TypeMismatch, "Node type does not match Get..() type.");
+				return ReadStatus::Success;
+			}
+
+			/// <summary>Verifies that a primitive of the Expected type from the common primitive set is open for reading.</summary>
+			ReadStatus CheckCommonPrimitive(PrimitiveTypes Expected)
+			{
+				ReadStatus Status = CheckPrimitive(Expected);
+				if (Status != ReadStatus::Success) return Status;
+				if (Options.CommonCodec == Codecs::NotLoaded) 
+					return Fail(ReadStatus::CodecNotLoaded, "A codec for the common primitive set has not been loaded by the DML stream.");
+				m_pReader->IsLittleEndian = (Options.CommonCodec == Codecs::LE);
+				return ReadStatus::Success;
+			}
+
 			/** Internal Parsing Data **/
 
 			/// <summary>
@@ -43,7 +220,7 @@ namespace wb
 				if (Options.ArrayCodec == Codecs::NotLoaded) throw CreateDmlException("A codec for the arrays primitive set has not been loaded by the DML stream.");
 				m_pReader->IsLittleEndian = (Options.ArrayCodec == Codecs::LE);				
 
-				UInt64 Elements = m_pReader->ReadCompact64();
+				UInt64 Elements = ReadArrayLength();
 				if (Elements > size_t_MaxValue) throw CreateDmlException("Array size exceeds platform capacity.");
 				vector<T> Value((size_t)Elements);
 				m_pReader->Read(&(Value[0]), Elements);
@@ -51,6 +228,49 @@ namespace wb
 				return Value;
 			}
 
+			template <class T> void GetTemplateArray(ArrayTypes ExpectedArrayType, vector<T>& Value)
+			{
+				if (GetPrimitiveType() != PrimitiveTypes::Array || GetArrayType() != ExpectedArrayType) throw CreateDmlException("Cannot read array of a different type.");
+				if (Options.ArrayCodec == Codecs::NotLoaded) throw CreateDmlException("A codec for the arrays primitive set has not been loaded by the DML stream.");
+				m_pReader->IsLittleEndian = (Options.ArrayCodec == Codecs::LE);
+
+				UInt64 Elements = ReadArrayLength();
+				if (Elements > size_t_MaxValue) throw CreateDmlException("Array size exceeds platform capacity.");
+				Value.resize((size_t)Elements);
+				if (Elements > 0) m_pReader->Read(&(Value[0]), Elements);
+				m_pAssociation = nullptr;
+			}
+
+			template <class T> size_t GetTemplateArray(ArrayTypes ExpectedArrayType, T* pValue, size_t Capacity)
+			{
+				if (GetPrimitiveType() != PrimitiveTypes::Array || GetArrayType() != ExpectedArrayType) throw CreateDmlException("Cannot read array of a different type.");
+				if (Options.ArrayCodec == Codecs::NotLoaded) throw CreateDmlException("A codec for the arrays primitive set has not been loaded by the DML stream.");
+				m_pReader->IsLittleEndian = (Options.ArrayCodec == Codecs::LE);
+
+				// The length is only peeked until the content is known to fit, so that the node remains readable after the exception.
+				if (PeekArrayLength() > Capacity) throw CreateDmlException("Array does not fit in the buffer provided.  See GetArrayLength().");
+				UInt64 Elements = ReadArrayLength();
+				if (Elements > 0) m_pReader->Read(pValue, Elements);
+				m_pAssociation = nullptr;
+				return (size_t)Elements;
+			}
+
+			/// <summary>Reads the content of a DateTime array into pValue, which has room for at least Elements.</summary>
+			void ReadDateTimeContent(DateTime* pValue, UInt64 Elements)
+			{
+				// The raw values are read in blocks through m_Scratch, so that no allocation is needed once it has grown.
+				const UInt64 BlockElements = 4096;
+				UInt64 nBlock = (Elements < BlockElements) ? Elements : BlockElements;
+				if (m_Scratch.GetSize() < nBlock * sizeof(Int64)) m_Scratch.Alloc(nBlock * sizeof(Int64));
+				Int64* pRaw = (Int64*)m_Scratch.At();
+				for (UInt64 Done = 0; Done < Elements; Done += nBlock)
+				{
+					if (Elements - Done < nBlock) nBlock = Elements - Done;
+					m_pReader->Read(pRaw, (Int64)nBlock);
+					for (UInt64 ii = 0; ii < nBlock; ii++) pValue[Done + ii] = FromNanoseconds(pRaw[ii]);
+				}
+			}
+
 			template <class T> matrix<T> GetTemplateMatrix(ArrayTypes ExpectedMatrixType)
 			{
 				if (GetPrimitiveType() != PrimitiveTypes::Matrix || GetArrayType() != ExpectedMatrixType) throw CreateDmlException("Cannot read matrix of a different type.");
@@ -66,6 +286,195 @@ namespace wb
 				return Value;
 			}
 
+			/// <summary>Indicates whether the content of the open array or matrix node, which follows its element count or dimensions,
+			/// lies in the stream's read window at an address that is a multiple of Alignment.</summary>
+			bool IsContentAligned(size_t Alignment)
+			{
+				Int64 nAvailable;
+				const byte* pContent = m_pReader->m_pStream->GetReadWindow(nAvailable);
+				int nHeaders = (GetPrimitiveType() == PrimitiveTypes::Matrix) ? 2 : (m_HasArrayLength ? 0 : 1);
+				for (; nHeaders > 0; nHeaders--)
+				{
+					if (nAvailable < 1) return false;
+					int nLength = BinaryReader::SizeCompact64(*pContent);
+					pContent += nLength;
+					nAvailable -= nLength;
+				}
+				return nAvailable > 0 && ((size_t)pContent % Alignment) == 0;
+			}
+
+			template <class T> array_view<T> GetTemplateArrayView(ArrayTypes ExpectedArrayType)
+			{
+				if (GetPrimitiveType() != PrimitiveTypes::Array || GetArrayType() != ExpectedArrayType) throw CreateDmlException("Cannot read array of a different type.");
+				if (!CanGetView()) throw CreateDmlException("Array cannot be viewed in place.  Use the Get...Array() form instead.");
+
+				UInt64 Elements = ReadArrayLength();
+				if (Elements > size_t_MaxValue / sizeof(T)) throw CreateDmlException("Array size exceeds platform capacity.");
+				const T* pData = (Elements > 0) ? (const T*)m_pReader->ReadDirect(Elements * sizeof(T)) : nullptr;
+				m_pAssociation = nullptr;
+				return array_view<T>(pData, (size_t)Elements);
+			}
+
+			template <class T> matrix_view<T> GetTemplateMatrixView(ArrayTypes ExpectedMatrixType)
+			{
+				if (GetPrimitiveType() != PrimitiveTypes::Matrix || GetArrayType() != ExpectedMatrixType) throw CreateDmlException("Cannot read matrix of a different type.");
+				if (!CanGetView()) throw CreateDmlException("Matrix cannot be viewed in place.  Use the Get...Matrix() form instead.");
+
+				UInt64 Columns = m_pReader->ReadCompact64();        // Columns
+				UInt64 Rows = m_pReader->ReadCompact64();			// Rows
+				if (Columns > size_t_MaxValue || Rows > size_t_MaxValue || (Columns > 0 && Rows > size_t_MaxValue / Columns / sizeof(T))) 
+					throw CreateDmlException("Matrix size exceeds platform capacity.");
+				const T* pData = (Rows * Columns > 0) ? (const T*)m_pReader->ReadDirect(Rows * Columns * sizeof(T)) : nullptr;
+				m_pAssociation = nullptr;
+				return matrix_view<T>(pData, (size_t)Rows, (size_t)Columns);
+			}
+
+			/** Accept() support **/
+
+			/// <summary>Reads nElements of array content, in place if the stream permits and otherwise into m_Scratch.  The type and
+			/// codec have already been verified and IsLittleEndian set.</summary>
+			template <class T> const T* ReadArrayContent(UInt64 nElements)
+			{
+				if (nElements > size_t_MaxValue / sizeof(T)) throw CreateDmlException("Array size exceeds platform capacity.");
+				if (nElements == 0) return nullptr;
+				UInt64 nBytes = nElements * sizeof(T);
+				if (m_pReader->m_pStream->CanReadDirect() && (sizeof(T) == 1 || m_pReader->IsNativeOrder()))
+				{
+					// The content follows variable-length headers, so it is used in place only when it happens to be aligned for T.
+					Int64 nAvailable;
+					const byte* pWindow = m_pReader->m_pStream->GetReadWindow(nAvailable);
+					if (nAvailable > 0 && ((size_t)pWindow % alignof(T)) == 0) return (const T*)m_pReader->ReadDirect(nBytes);
+				}
+				if (m_Scratch.GetSize() < nBytes) m_Scratch.Alloc(nBytes);
+				m_pReader->Read((T*)m_Scratch.At(), (Int64)nElements);
+				return (const T*)m_Scratch.At();
+			}
+
+			template <class T> array_view<T> ReadArrayView()
+			{
+				UInt64 nElements = ReadArrayLength();
+				const T* pData = ReadArrayContent<T>(nElements);
+				return array_view<T>(pData, (size_t)nElements);
+			}
+
+			template <class T> matrix_view<T> ReadMatrixView()
+			{
+				UInt64 Columns = m_pReader->ReadCompact64();        // Columns
+				UInt64 Rows = m_pReader->ReadCompact64();			// Rows
+				if (Columns > size_t_MaxValue || Rows > size_t_MaxValue || (Columns > 0 && Rows > size_t_MaxValue / Columns / sizeof(T))) 
+					throw CreateDmlException("Matrix size exceeds platform capacity.");
+				const T* pData = ReadArrayContent<T>(Rows * Columns);
+				return matrix_view<T>(pData, (size_t)Rows, (size_t)Columns);
+			}
+
+			/// <summary>Decodes the open primitive node once and passes it to the visitor's handler for its type.  Types that the
+			/// reader does not support are left for the next Read() to skip.</summary>
+			template <class Visitor> void AcceptPrimitive(Visitor& V, string& Text)
+			{
+				// Verify the codec while the reader still owns the association, so that the node remains intact on failure.
+				switch (m_pAssociation->PrimitiveType)
+				{
+				case PrimitiveTypes::DateTime: 
+				case PrimitiveTypes::Single: 
+				case PrimitiveTypes::Double:
+					if (Options.CommonCodec == Codecs::NotLoaded) throw CreateDmlException("A codec for the common primitive set has not been loaded by the DML stream.");
+					break;
+				case PrimitiveTypes::Array:
+				case PrimitiveTypes::Matrix:
+					if (Options.ArrayCodec == Codecs::NotLoaded) throw CreateDmlException("A codec for the arrays primitive set has not been loaded by the DML stream.");
+					break;
+				default: break;
+				}
+
+				// Hold the association while the node is decoded and the handler runs, since it may belong to this node alone.
+				// Any path that does not complete the node hands it back to the reader.
+				r_ptr<Association> pNode = std::move(m_pAssociation);
+				m_pAssociation = r_ptr<Association>::absolved(*pNode);
+				const Association& Node = *pNode;
+
+				try
+				{
+					switch (Node.PrimitiveType)
+					{
+					case PrimitiveTypes::UInt: 
+						{
+							UInt64 Value = m_pReader->ReadCompact64();
+							NoteUInt(Value);
+							V.OnUInt(Node, Value);
+							break;
+						}
+					case PrimitiveTypes::Int: V.OnInt(Node, m_pReader->ReadCompactS64()); break;
+					case PrimitiveTypes::Boolean: V.OnBoolean(Node, m_pReader->ReadByte() != 0); break;
+					case PrimitiveTypes::String:
+						{
+							UInt64 Length = m_pReader->ReadCompact64();
+							if (Length > Int32_MaxValue) throw CreateDmlException("Strings longer than 2^32 are not supported.");
+							Text.resize((size_t)Length);
+							if (Length > 0) m_pReader->Read(&(Text[0]), (Int64)Length);
+							V.OnString(Node, Text);
+							break;
+						}
+					case PrimitiveTypes::DateTime: 
+					case PrimitiveTypes::Single: 
+					case PrimitiveTypes::Double:
+						m_pReader->IsLittleEndian = (Options.CommonCodec == Codecs::LE);
+						switch (Node.PrimitiveType)
+						{
+						case PrimitiveTypes::DateTime: V.OnDateTime(Node, FromNanoseconds(m_pReader->ReadInt64())); break;
+						case PrimitiveTypes::Single: V.OnSingle(Node, m_pReader->ReadSingle()); break;
+						default: V.OnDouble(Node, m_pReader->ReadDouble()); break;
+						}
+						break;
+					case PrimitiveTypes::Array:
+						m_pReader->IsLittleEndian = (Options.ArrayCodec == Codecs::LE);
+						switch (Node.ArrayType)
+						{
+						case ArrayTypes::U8: V.OnByteArray(Node, ReadArrayView<byte>()); break;
+						case ArrayTypes::U16: V.OnUInt16Array(Node, ReadArrayView<UInt16>()); break;
+						case ArrayTypes::U32: V.OnUInt32Array(Node, ReadArrayView<UInt32>()); break;
+						case ArrayTypes::U64: V.OnUInt64Array(Node, ReadArrayView<UInt64>()); break;
+						case ArrayTypes::I8: V.OnInt8Array(Node, ReadArrayView<char>()); break;
+						case ArrayTypes::I16: V.OnInt16Array(Node, ReadArrayView<Int16>()); break;
+						case ArrayTypes::I32: V.OnInt32Array(Node, ReadArrayView<Int32>()); break;
+						case ArrayTypes::I64: V.OnInt64Array(Node, ReadArrayView<Int64>()); break;
+						case ArrayTypes::Singles: V.OnSingleArray(Node, ReadArrayView<float>()); break;
+						case ArrayTypes::Doubles: V.OnDoubleArray(Node, ReadArrayView<double>()); break;
+						case ArrayTypes::DateTimes: V.OnDateTimeArray(Node, GetDateTimeArray()); break;
+						case ArrayTypes::Strings: V.OnStringArray(Node, GetStringArray()); break;
+						default: m_pAssociation = std::move(pNode); return;
+						}
+						break;
+					case PrimitiveTypes::Matrix:
+						m_pReader->IsLittleEndian = (Options.ArrayCodec == Codecs::LE);
+						switch (Node.ArrayType)
+						{
+						case ArrayTypes::U8: V.OnUInt8Matrix(Node, ReadMatrixView<UInt8>()); break;
+						case ArrayTypes::U16: V.OnUInt16Matrix(Node, ReadMatrixView<UInt16>()); break;
+						case ArrayTypes::U32: V.OnUInt32Matrix(Node, ReadMatrixView<UInt32>()); break;
+						case ArrayTypes::U64: V.OnUInt64Matrix(Node, ReadMatrixView<UInt64>()); break;
+						case ArrayTypes::I8: V.OnInt8Matrix(Node, ReadMatrixView<char>()); break;
+						case ArrayTypes::I16: V.OnInt16Matrix(Node, ReadMatrixView<Int16>()); break;
+						case ArrayTypes::I32: V.OnInt32Matrix(Node, ReadMatrixView<Int32>()); break;
+						case ArrayTypes::I64: V.OnInt64Matrix(Node, ReadMatrixView<Int64>()); break;
+						case ArrayTypes::Singles: V.OnSingleMatrix(Node, ReadMatrixView<float>()); break;
+						case ArrayTypes::Doubles: V.OnDoubleMatrix(Node, ReadMatrixView<double>()); break;
+						default: m_pAssociation = std::move(pNode); return;
+						}
+						break;
+					default: 
+						// Leave the node open for the next Read() to skip, keeping the association it refers to.
+						m_pAssociation = std::move(pNode);
+						return;
+					}
+				}
+				catch (...)
+				{
+					m_pAssociation = std::move(pNode);
+					throw;
+				}
+				m_pAssociation = nullptr;
+			}
+
 			#pragma endregion
 
 		public:			
@@ -92,6 +501,33 @@ namespace wb
 				Codecs CommonCodec;
 				Codecs ArrayCodec;
 
+				/// <summary>
+				/// FileBufferSize gives the size, in bytes, of the read buffer placed in front of the file when the
+				/// DmlReader is created from a filename.  Set to zero to read from the file without buffering.
+				/// </summary>
+				UInt32 FileBufferSize;
+
+				/// <summary>
+				/// Set MapFile to true to instruct the DmlReader to memory-map the file when it is created from a filename,
+				/// instead of reading it through a buffer.  Mapping is preferable for random access (GetContext() and 
+				/// SeekAbsolute()) over large files.  FileBufferSize is not used when MapFile is true.  Default is false.
+				/// </summary>
+				bool MapFile;
+
+				/// <summary>
+				/// Set AccessHints to true (default) to have the DmlReader advise the operating system of its access pattern on
+				/// seekable streams: sequential access while reading, the data at the target of a seek, and release from the cache
+				/// of data that a long scan has left behind.  Hints affect only caching and read-ahead, never the data read.
+				/// </summary>
+				bool AccessHints;
+
+				/// <summary>
+				/// DiscardBufferSize gives the size, in bytes, of the buffer used to discard skipped content (such as comments, 
+				/// padding, and unread nodes) from streams that can neither seek nor provide their own buffered data, such as an
+				/// unbuffered pipe.  The buffer is allocated once per reader, when first needed.
+				/// </summary>
+				UInt32 DiscardBufferSize;
+
 				#if 0
 				internal List<IDmlReaderExtension> Extensions = new List<IDmlReaderExtension>();
 
@@ -107,11 +543,16 @@ namespace wb
 					DiscardPadding = true;
 					CommonCodec = Codecs::NotLoaded;
 					ArrayCodec = Codecs::NotLoaded;
+					FileBufferSize = BufferedStream::DefaultBufferSize;
+					MapFile = false;
+					AccessHints = true;
+					DiscardBufferSize = 65536;
 				}
 
 				ParsingOptions(const ParsingOptions& cp)
 					: DiscardComments(cp.DiscardComments), DiscardPadding(cp.DiscardPadding),
-					CommonCodec(cp.CommonCodec), ArrayCodec(cp.ArrayCodec)
+					CommonCodec(cp.CommonCodec), ArrayCodec(cp.ArrayCodec), FileBufferSize(cp.FileBufferSize), MapFile(cp.MapFile),
+					AccessHints(cp.AccessHints), DiscardBufferSize(cp.DiscardBufferSize)
 				{ }
 			};
 
@@ -136,11 +577,69 @@ namespace wb
 				/// </summary>
 				Int64 ContextPosition;				
 
+				/// <summary>
+				/// ContentSize records the DML:ContentSize attribute of the container once it has been read: the size, in bytes, of the
+				/// container's elements between its End-Attributes and End-Container markers.  It has the value UInt64_MaxValue if
+				/// the container has no ContentSize attribute or it has not been read yet.
+				/// </summary>
+				UInt64 ContentSize;
+
+				/// <summary>
+				/// ElementsPosition stores the position following the End-Attributes marker, where the elements begin.  It is
+				/// recorded only for containers with a ContentSize on seekable streams, and otherwise has the value Int64_MaxValue.
+				/// </summary>
+				Int64 ElementsPosition;
+
+				/// <summary>
+				/// ActiveTranslation is the translation in effect within this container, resolved once when the container is
+				/// opened: the container's local translation if it has one, or otherwise the active translation of its parent.
+				/// It is nullptr when the reader's global translation is in effect, so that it remains valid if the DmlReader
+				/// is moved.
+				/// </summary>
+				Translation* ActiveTranslation;
+
+				/// <summary>
+				/// References counts the pointers to this context: the DmlReader's pointer to its current container, and the 
+				/// m_pContainer pointers of contexts nested within it, including copies held by the caller.  A context is freed
+				/// when its last reference is released, so a copy remains valid after the reader has left the container.
+				/// </summary>
+				UInt32 References;
+
+				/// <summary>Releases one reference to pContext, freeing it and releasing its parent if that was the last one.</summary>
+				static void Release(DmlContext* pContext)
+				{
+					while (pContext != nullptr && --pContext->References == 0)
+					{
+						DmlContext* pParent = pContext->m_pContainer;
+						pContext->m_pContainer = nullptr;
+						delete pContext;
+						pContext = pParent;
+					}
+				}
+
+				/// <summary>Makes this context, which must be empty, a copy of cp.  The parent chain is shared by reference.  Associations
+				/// that belong to a translation or to the reader are shared as well, since they do not change while the reader exists,
+				/// so a copy costs the same regardless of the size of any local translation.  Only an association that cp owns by
+				/// itself is copied.</summary>
+				void Assign(const DmlContext& cp)
+				{
+					OutOfBand = cp.OutOfBand;
+					StartPosition = cp.StartPosition;
+					ContextPosition = cp.ContextPosition;
+					ContentSize = cp.ContentSize;
+					ElementsPosition = cp.ElementsPosition;
+					ActiveTranslation = cp.ActiveTranslation;
+					m_pContainer = cp.m_pContainer;
+					if (m_pContainer != nullptr) m_pContainer->References++;
+					if (!cp.m_pAssociation.IsAssigned()) m_pAssociation = nullptr;
+					else if (cp.m_pAssociation.IsResponsible()) m_pAssociation = r_ptr<Association>::responsible(new Association(*cp.m_pAssociation));
+					else m_pAssociation = r_ptr<Association>::absolved(cp.m_pAssociation);
+				}
+
 			public:
 
-				/** Responsibility for freeing this object lies with DmlReader, which will free all objects connected
-					up the tree.  Since responsibility lies with the DmlReader or other owner of the object, the copy
-					of a DmlContext results in a shallow copy of this pointer. **/
+				/** The parent context.  The pointer holds a reference to the parent, so that the chain up the tree remains valid for
+					as long as this context exists.  The copy of a DmlContext shares the same parent. **/
 				DmlContext *m_pContainer;
 
 				/// <summary>Provides the DML association of this container.</summary>
@@ -148,12 +647,10 @@ namespace wb
 				
 				DmlContext(const DmlContext& cp)
 					: 
-					OutOfBand(cp.OutOfBand),
-					StartPosition(cp.StartPosition),
-					ContextPosition(cp.ContextPosition),
-					m_pContainer(cp.m_pContainer),
-					m_pAssociation(r_ptr<Association>::responsible(new Association(*cp.m_pAssociation)))
+					References(1),
+					m_pContainer(nullptr)
 				{
+					Assign(cp);
 				}
 				
 				DmlContext()
@@ -161,27 +658,43 @@ namespace wb
 					OutOfBand(false),
 					StartPosition(Int64_MaxValue),
 					ContextPosition(Int64_MaxValue),
+					ContentSize(UInt64_MaxValue),
+					ElementsPosition(Int64_MaxValue),
+					ActiveTranslation(nullptr),
+					References(1),
 					m_pContainer(nullptr),
 					m_pAssociation(nullptr)
 				{
 				}
 
-/*
+				~DmlContext()
+				{
+					Release(m_pContainer);
+				}
+
 				DmlContext& operator=(const DmlContext& cp)
-				{					
-					OutOfBand = cp.OutOfBand;
-					StartPosition = cp.StartPosition;					
-					ContextPosition = cp.ContextPosition;
-					m_pContainer = cp.m_pContainer;
-					m_pAssociation = new Association(*cp.m_pAssociation);
+				{
+					if (&cp == this) return *this;
+					DmlContext* pOldParent = m_pContainer;
+					m_pAssociation = nullptr;
+					Assign(cp);
+					Release(pOldParent);
 					return *this;
 				}
-				*/
 
 				/// <summary>
 				/// Name provides the XML-Compatible name for this container.
 				/// </summary>
 				string GetName() { return m_pAssociation->Name; }
+
+				/// <summary>
+				/// IsContentSizeKnown() indicates whether the DML:ContentSize attribute of this container has been read, in which case
+				/// DmlReader::SkipContainer() can pass over its elements without reading them.
+				/// </summary>
+				bool IsContentSizeKnown() const { return ContentSize != UInt64_MaxValue; }
+
+				/// <summary>Provides the DML:ContentSize of this container, or UInt64_MaxValue if it is not known.</summary>
+				UInt64 GetContentSize() const { return ContentSize; }
 			};
 
 			#pragma endregion
@@ -259,6 +772,57 @@ namespace wb
 
 			#pragma endregion
 
+		private:
+
+			#pragma region "Context Pool"
+
+			/// <summary>Contexts of closed containers, kept for reuse and linked through their m_pContainer pointers.  Containers are
+			/// opened and closed in LIFO order, so the list holds no more contexts than the deepest nesting seen, and opening or closing
+			/// a container does not allocate.  Contexts still referenced by a copy held by the caller are not returned to the pool
+			/// until the last reference is released here; if it is released by the copy, the context is freed instead.</summary>
+			DmlContext* m_pFreeContexts;
+
+			/// <summary>Returns an empty context holding one reference.</summary>
+			DmlContext* NewContext()
+			{
+				if (m_pFreeContexts == nullptr) return new DmlContext();
+				DmlContext* pContext = m_pFreeContexts;
+				m_pFreeContexts = pContext->m_pContainer;
+				pContext->m_pContainer = nullptr;
+				pContext->References = 1;
+				return pContext;
+			}
+
+			/// <summary>Releases one reference to pContext, returning it to the pool and releasing its parent if that was the last
+			/// one.</summary>
+			void ReleaseContext(DmlContext* pContext)
+			{
+				while (pContext != nullptr && --pContext->References == 0)
+				{
+					DmlContext* pParent = pContext->m_pContainer;
+					RecycleContext(pContext);
+					pContext = pParent;
+				}
+			}
+
+			/// <summary>Returns an unreferenced context to the pool in the state of a newly constructed DmlContext.</summary>
+			void RecycleContext(DmlContext* pContext)
+			{
+				pContext->m_pAssociation = nullptr;				// Frees the association if the context was responsible for it.
+				pContext->OutOfBand = false;
+				pContext->StartPosition = Int64_MaxValue;
+				pContext->ContextPosition = Int64_MaxValue;
+				pContext->ContentSize = UInt64_MaxValue;
+				pContext->ElementsPosition = Int64_MaxValue;
+				pContext->ActiveTranslation = nullptr;
+				pContext->m_pContainer = m_pFreeContexts;
+				m_pFreeContexts = pContext;
+			}
+
+			#pragma endregion
+
+		public:
+
 			#pragma region "Initialization"
 
 			/** Initialization **/			
@@ -269,34 +833,71 @@ namespace wb
 				m_pContainer = nullptr;
 				IsAttribute = false;
 				GlobalTranslation.Add(Translation::DML3);
+				m_pFreeContexts = nullptr;
+				m_ReleasedThrough = Int64_MaxValue;
+				m_AdvisedSequential = false;
+				m_Status = ReadStatus::Success;
+				m_pStatusMessage = nullptr;
+				m_StatusID = 0;
+				m_ArrayLength = 0;
+				m_HasArrayLength = false;
 			}
 
 			DmlReader(DmlReader&& mv)
 				: m_pReader(std::move(mv.m_pReader)),
+				m_Scratch(std::move(mv.m_Scratch)),
+				m_ArrayLength(mv.m_ArrayLength),
+				m_HasArrayLength(mv.m_HasArrayLength),
+				m_ReleasedThrough(mv.m_ReleasedThrough),
+				m_AdvisedSequential(mv.m_AdvisedSequential),
+				m_Status(mv.m_Status),
+				m_pStatusMessage(mv.m_pStatusMessage),
+				m_StatusID(mv.m_StatusID),
 				Options(std::move(mv.Options)),
 				m_pAssociation(std::move(mv.m_pAssociation)),
 				m_pContainer(std::move(mv.m_pContainer)),				
 				IsAttribute(mv.IsAttribute),
-				GlobalTranslation(std::move(mv.GlobalTranslation))
+				GlobalTranslation(std::move(mv.GlobalTranslation)),
+				m_pFreeContexts(mv.m_pFreeContexts)
 			{
+				mv.m_pContainer = nullptr;
+				mv.m_pFreeContexts = nullptr;
+				m_InlineAssociations.swap(mv.m_InlineAssociations);
 			}
 
 			~DmlReader()
 			{
-				while (m_pContainer != nullptr)
+				DmlContext::Release(m_pContainer);
+				m_pContainer = nullptr;
+				while (m_pFreeContexts != nullptr)
 				{
-					DmlContext* pParent = m_pContainer->m_pContainer;
-					delete m_pContainer;
-					m_pContainer = pParent;
+					DmlContext* pNext = m_pFreeContexts->m_pContainer;
+					m_pFreeContexts->m_pContainer = nullptr;
+					delete m_pFreeContexts;
+					m_pFreeContexts = pNext;
 				}
+				for (auto it = m_InlineAssociations.begin(); it != m_InlineAssociations.end(); it++) delete it->second;
 			}
 
 			/** Create() **/
 
+		private:
+
+			/// <summary>Opens a file for reading, either memory-mapped or with a BufferedStream in front of the file, as selected by the options.</summary>
+			static r_ptr<Stream> OpenFile(const string& Filename, const ParsingOptions& Options)
+			{
+				if (Options.MapFile) return r_ptr<Stream>::responsible(new MappedFileStream(Filename));
+				r_ptr<Stream> pFile = r_ptr<Stream>::responsible(new FileStream(Filename.c_str(), FileMode::Open));
+				if (Options.FileBufferSize == 0) return pFile;
+				return r_ptr<Stream>::responsible(new BufferedStream(std::move(pFile), Options.FileBufferSize));
+			}
+
+		public:
+
 			static DmlReader Create(string Filename)
 			{
 				DmlReader ret;
-				r_ptr<Stream> pBase = r_ptr<Stream>::responsible(new FileStream(Filename.c_str(), FileMode::Open));
+				r_ptr<Stream> pBase = OpenFile(Filename, ret.Options);
 				ret.m_pReader = r_ptr<BinaryReader>::responsible(new BinaryReader(std::move(pBase), false));
 				return ret;
 			}
@@ -304,7 +905,7 @@ namespace wb
 			static DmlReader Create(string Filename, ParsingOptions Options)
 			{
 				DmlReader ret;
-				r_ptr<Stream> pBase = r_ptr<Stream>::responsible(new FileStream(Filename.c_str(), FileMode::Open));
+				r_ptr<Stream> pBase = OpenFile(Filename, Options);
 				ret.m_pReader = r_ptr<BinaryReader>::responsible(new BinaryReader(std::move(pBase), false));
 				ret.Options = Options;
 				return ret;
@@ -333,6 +934,34 @@ namespace wb
 				ret.m_pContainer = pContext;
 				return ret;
 			}
+
+			/// <summary>Creates a reader over DML content that is already in memory, such as a received message, without copying it.
+			/// The buffer remains owned by the caller and must stay valid and unchanged until the reader is destroyed.</summary>
+			static DmlReader Create(const void* pBuffer, size_t nLength)
+			{
+				return Create(r_ptr<Stream>::responsible(new BufferViewStream(pBuffer, nLength)));
+			}
+
+			static DmlReader Create(const void* pBuffer, size_t nLength, ParsingOptions Options)
+			{
+				return Create(r_ptr<Stream>::responsible(new BufferViewStream(pBuffer, nLength)), Options);
+			}
+
+			/// <summary>Creates a reader with its own position over a file that may be shared with other readers, including readers
+			/// on other threads.  Each thread must use its own DmlReader.  The SharedFile must remain open until the reader is
+			/// destroyed.  Options.FileBufferSize gives the size of the reader's buffer.  Because each reader keeps its own
+			/// position, reads always pass through a buffer here, and a FileBufferSize of zero selects 
+			/// SharedFileStream::DefaultBufferSize rather than unbuffered access.</summary>
+			static DmlReader Create(const SharedFile& File)
+			{
+				return Create(File, ParsingOptions());
+			}
+
+			static DmlReader Create(const SharedFile& File, ParsingOptions Options)
+			{
+				UInt32 BufferSize = (Options.FileBufferSize > 0) ? Options.FileBufferSize : SharedFileStream::DefaultBufferSize;
+				return Create(r_ptr<Stream>::responsible(new SharedFileStream(File, 0, BufferSize)), Options);
+			}
 			
 			#pragma endregion
 
@@ -398,18 +1027,16 @@ namespace wb
 
 			/** Read() Method **/
 
-			/// <summary>
-			/// The Read() function reads the node head for the next node.  The actual contents of the
-			/// node are retrieved by the Get..() calls or are skipped if another Read() call is made before
-			/// being retrieved.
-			/// </summary>
-			/// <returns>True if a node was read.  False if the end of the document has been reached.  Throws
-			/// exceptions if any format violation occurs.</returns>
-			bool Read()
+		private:
+
+			/// <summary>Reads the node head for the next node, reporting the expected conditions through the return value.</summary>
+			ReadStatus ReadNode()
 			{
 				FinishNode();
 				// FinishNode() ensures that m_pAssociation is null upon successful return.
 				assert(!IsNodeOpen());
+				m_HasArrayLength = false;
+				if (Options.AccessHints) AdviseScan();
 
 				UInt32 DMLID;
 				for (; ; )
@@ -418,9 +1045,9 @@ namespace wb
 
 					try
 					{
-						DMLID = m_pReader->ReadCompact32();
+						if (!m_pReader->TryReadCompact32(DMLID)) return Fail(ReadStatus::EndOfStream, "End of stream.");
 					}
-					catch (EndOfStreamException&) { return false; }
+					catch (EndOfStreamException&) { return Fail(ReadStatus::EndOfStream, "End of stream."); }
 					catch (std::exception& ex) { throw CreateDmlException(ex.what()); }
 
 					// Handle special cases first...
@@ -428,12 +1055,14 @@ namespace wb
 					{
 					case dmltsl::dml3::idDMLEndAttributes:
 						m_pAssociation = r_ptr<Association>::absolved(dmltsl::dml3::EndAttributes);
-						return true;
+						if (m_pContainer != nullptr && m_pContainer->IsContentSizeKnown() && m_pReader->m_pStream->CanSeek())
+							m_pContainer->ElementsPosition = m_pReader->GetPosition();
+						return ReadStatus::Success;
 
 					case dmltsl::dml3::idDMLEndContainer:
-						if (m_pContainer == nullptr || m_pContainer->OutOfBand) throw CreateDmlException("Mismatch between opening and closing of containers.");
+						if (m_pContainer == nullptr || m_pContainer->OutOfBand) return Fail(ReadStatus::Misplaced, "Mismatch between opening and closing of containers.");
 						m_pAssociation = r_ptr<Association>::absolved(dmltsl::dml3::EndContainer);
-						return true;						
+						return ReadStatus::Success;						
 
 					case dmltsl::dml3::idDMLPadding:
 						if (Options.DiscardPadding)
@@ -446,7 +1075,7 @@ namespace wb
 						else
 						{
 							m_pAssociation = r_ptr<Association>::absolved(dmltsl::dml3::Padding);
-							return true;
+							return ReadStatus::Success;
 						}
 
 					case dmltsl::dml3::idDMLPaddingByte:
@@ -454,7 +1083,7 @@ namespace wb
 						else
 						{
 							m_pAssociation = r_ptr<Association>::absolved(dmltsl::dml3::PaddingByte);
-							return true;
+							return ReadStatus::Success;
 						}
 					}
 
@@ -471,7 +1100,10 @@ namespace wb
 					{
 						Association* pFound;
 						if (!GetActiveTranslation()->TryFind(DMLID, pFound))
-							throw CreateDmlException("Association for DMLID 0x" + to_hex_string(DMLID) + " not found in active DML translation.");
+						{
+							m_StatusID = DMLID;
+							return Fail(ReadStatus::UnknownID, nullptr);
+						}
 						pCurrentAssociation = r_ptr<Association>::absolved(pFound);									// Non-responsible transfer.
 					}
 
@@ -481,21 +1113,23 @@ namespace wb
 					{
 					case NodeTypes::Container:
 						{
-							DmlContext* pNewContainer = new DmlContext();
+							DmlContext* pNewContainer = NewContext();
 							pNewContainer->m_pContainer = m_pContainer;
 							pNewContainer->m_pAssociation = std::move(pCurrentAssociation);		// Transfer responsibility.
-							if (m_pReader->m_pStream->CanSeek()) pNewContainer->StartPosition = m_pReader->m_pStream->GetPosition();							
+							if (pNewContainer->m_pAssociation->pLocalTranslation != nullptr) pNewContainer->ActiveTranslation = pNewContainer->m_pAssociation->pLocalTranslation;
+							else if (m_pContainer != nullptr) pNewContainer->ActiveTranslation = m_pContainer->ActiveTranslation;
+							if (m_pReader->m_pStream->CanSeek()) pNewContainer->StartPosition = m_pReader->GetPosition();							
 							m_pAssociation = r_ptr<Association>::absolved(*pNewContainer->m_pAssociation);					// Make a non-responsible copy.
 							m_pContainer = pNewContainer;
 							IsAttribute = true;
-							return true;
+							return ReadStatus::Success;
 						}
 
 					case NodeTypes::Primitive:
 						{
 							m_pAssociation = std::move(pCurrentAssociation);
 							// if (m_pAssociation->PrimitiveType == PrimitiveTypes::Extension) Association.DMLName.Extension.OpenNode(Association, Reader);
-							return true;
+							return ReadStatus::Success;
 						}
 
 					case NodeTypes::Comment:
@@ -507,7 +1141,7 @@ namespace wb
 								continue;
 							}
 							m_pAssociation = r_ptr<Association>::absolved(dmltsl::dml3::Comment);
-							return true;
+							return ReadStatus::Success;
 						}
 
 					default: throw CreateDmlException("Unrecognized or disallowed node type in translation.");
@@ -515,6 +1149,48 @@ namespace wb
 				}
 			}     
 
+		public:
+
+			/// <summary>
+			/// The Read() function reads the node head for the next node.  The actual contents of the
+			/// node are retrieved by the Get..() calls or are skipped if another Read() call is made before
+			/// being retrieved.
+			/// </summary>
+			/// <returns>True if a node was read.  False if the end of the document has been reached.  Throws
+			/// exceptions if any format violation occurs.</returns>
+			bool Read()
+			{
+				ReadStatus Status = ReadNode();
+				if (Status == ReadStatus::Success) return true;
+				if (Status == ReadStatus::EndOfStream) return false;
+				throw DmlException(GetStatusMessage());
+			}
+
+			/// <summary>
+			/// TryRead() reads the node head for the next node in the same manner as Read(), but reports the end of the document, 
+			/// a DMLID that is not in the active translation, and a misplaced container end through its return value instead of 
+			/// an exception.  Damage to the encoding itself, such as a stream that ends within a node, still throws.  After an
+			/// unknown DMLID the node cannot be skipped and reading cannot continue.
+			/// </summary>
+			/// <returns>ReadStatus::Success if a node was read.</returns>
+			ReadStatus TryRead() { return ReadNode(); }
+
+			/// <summary>Returns the outcome of the most recent unsuccessful Try..() call.</summary>
+			ReadStatus GetStatus() const { return m_Status; }
+
+			/// <summary>
+			/// GetStatusMessage() describes the most recent unsuccessful Try..() call, including the location in the DML tree in
+			/// the same form as a DmlException.  The description is assembled only when requested, and should be retrieved before
+			/// reading further.
+			/// </summary>
+			string GetStatusMessage()
+			{
+				string Message;
+				if (m_Status == ReadStatus::UnknownID) Message = "Association for DMLID 0x" + to_hex_string(m_StatusID) + " not found in active DML translation.";
+				else if (m_pStatusMessage != nullptr) Message = m_pStatusMessage;
+				return Message + "\n" + GetErrorContext();
+			}
+
 			#pragma endregion
 
 			#pragma region "Get...() primitives"
@@ -527,6 +1203,7 @@ namespace wb
 			{            
 				if (GetPrimitiveType() != PrimitiveTypes::UInt) throw CreateDmlException("Node type does not match Get..() type.");
 				UInt64 Value = m_pReader->ReadCompact64();
+				NoteUInt(Value);
 				m_pAssociation = nullptr;
 				return Value;
 			}			
@@ -534,6 +1211,15 @@ namespace wb
 			/// <summary>Retrieves the value for a string primitive.</summary>
 			/// <returns>Value</returns>
 			string GetString()
+			{
+				string ret;
+				GetString(ret);
+				return ret;
+			}
+
+			/// <summary>Retrieves the value for a string primitive into Value, reusing its storage.  Reading a series of strings 
+			/// into the same string object requires no allocation once it has grown to the longest of them.</summary>
+			void GetString(string& Value)
 			{
 				try
 				{
@@ -542,11 +1228,9 @@ namespace wb
 					// This is an implementation limitation, not a limitation of DML.  Strings longer than 2^32 are unlikely anyway.
 					if (FullLength > Int32_MaxValue) throw CreateDmlException("Strings longer than 2^32 are not supported.");
 					int Length = (int)FullLength;
-					string ret;
-					ret.resize(Length);
-					m_pReader->Read(&(ret[0]), Length);					
+					Value.resize(Length);
+					if (Length > 0) m_pReader->Read(&(Value[0]), Length);
 					m_pAssociation = nullptr;
-					return ret;
 				}
 				catch (DmlException& dex) { throw dex; }
 				catch (std::exception& ex) { throw CreateDmlException(ex.what()); }
@@ -558,7 +1242,7 @@ namespace wb
 			{ 
 				if (GetPrimitiveType() != PrimitiveTypes::Array || GetArrayType() != ArrayTypes::U8) throw CreateDmlException("Cannot read array of a different type.");				
 
-				UInt64 Elements = m_pReader->ReadCompact64();
+				UInt64 Elements = ReadArrayLength();
 				if (Elements > size_t_MaxValue) throw Exception("DML array size exceeds platform capacity.");
 				vector<byte> Value((size_t)Elements);
 				m_pReader->Read(&(Value[0]), Elements);
@@ -573,6 +1257,14 @@ namespace wb
 			/// </summary>
 			/// <returns>Comment text</returns>
 			string GetComment()
+			{
+				string ret;
+				GetComment(ret);
+				return ret;
+			}
+
+			/// <summary>Retrieves the text for a comment node into Text, reusing its storage.</summary>
+			void GetComment(string& Text)
 			{
 				try
 				{
@@ -581,11 +1273,9 @@ namespace wb
 					// This is an implementation limitation, not a limitation of DML.  Strings longer than 2^32 are unlikely anyway.
 					if (FullLength > Int32_MaxValue) throw CreateDmlException("Strings longer than 2^32 are not supported.");
 					int Length = (int)FullLength;
-					string ret;
-					ret.resize(Length);
-					m_pReader->Read(&(ret[0]), Length);					
+					Text.resize(Length);
+					if (Length > 0) m_pReader->Read(&(Text[0]), Length);
 					m_pAssociation = nullptr;
-					return ret;
 				}
 				catch (DmlException& dex) { throw dex; }
 				catch (std::exception& ex) { throw CreateDmlException(ex.what()); }
@@ -663,6 +1353,75 @@ namespace wb
 				m_pAssociation = nullptr;
 				return Value;
 			}
+
+			/** Try..(): Base and common primitives **/
+
+			// The TryGet..() calls retrieve the value of the open node in the same manner as the corresponding Get..() call, but
+			// report a node of a different type, or no open node, through the return value.  After a mismatch the node remains
+			// open, so that another TryGet..() call can be made or the node can be skipped by the next Read().
+
+			ReadStatus TryGetUInt(UInt64& Value)
+			{
+				ReadStatus Status = CheckPrimitive(PrimitiveTypes::UInt);
+				if (Status != ReadStatus::Success) return Status;
+				Value = m_pReader->ReadCompact64();
+				NoteUInt(Value);
+				m_pAssociation = nullptr;
+				return ReadStatus::Success;
+			}
+
+			ReadStatus TryGetInt(Int64& Value)
+			{
+				ReadStatus Status = CheckPrimitive(PrimitiveTypes::Int);
+				if (Status != ReadStatus::Success) return Status;
+				Value = m_pReader->ReadCompactS64();
+				m_pAssociation = nullptr;
+				return ReadStatus::Success;
+			}
+
+			ReadStatus TryGetBoolean(bool& Value)
+			{
+				ReadStatus Status = CheckPrimitive(PrimitiveTypes::Boolean);
+				if (Status != ReadStatus::Success) return Status;
+				Value = (m_pReader->ReadByte() != 0);
+				m_pAssociation = nullptr;
+				return ReadStatus::Success;
+			}
+
+			ReadStatus TryGetString(string& Value)
+			{
+				ReadStatus Status = CheckPrimitive(PrimitiveTypes::String);
+				if (Status != ReadStatus::Success) return Status;
+				GetString(Value);
+				return ReadStatus::Success;
+			}
+
+			ReadStatus TryGetDateTime(DateTime& Value)
+			{
+				ReadStatus Status = CheckCommonPrimitive(PrimitiveTypes::DateTime);
+				if (Status != ReadStatus::Success) return Status;
+				Value = FromNanoseconds(m_pReader->ReadInt64());
+				m_pAssociation = nullptr;
+				return ReadStatus::Success;
+			}
+
+			ReadStatus TryGetSingle(float& Value)
+			{
+				ReadStatus Status = CheckCommonPrimitive(PrimitiveTypes::Single);
+				if (Status != ReadStatus::Success) return Status;
+				Value = m_pReader->ReadSingle();
+				m_pAssociation = nullptr;
+				return ReadStatus::Success;
+			}
+
+			ReadStatus TryGetDouble(double& Value)
+			{
+				ReadStatus Status = CheckCommonPrimitive(PrimitiveTypes::Double);
+				if (Status != ReadStatus::Success) return Status;
+				Value = m_pReader->ReadDouble();
+				m_pAssociation = nullptr;
+				return ReadStatus::Success;
+			}
 			
 			/** Get..(): Array Primitives **/
 
@@ -710,7 +1469,7 @@ namespace wb
 				if (Options.ArrayCodec == Codecs::NotLoaded) throw CreateDmlException("A codec for the arrays primitive set has not been loaded by the DML stream.");
 				m_pReader->IsLittleEndian = (Options.ArrayCodec == Codecs::LE);
 
-				UInt64 Elements = m_pReader->ReadCompact64();
+				UInt64 Elements = ReadArrayLength();
 				if (Elements > size_t_MaxValue) throw Exception("DML array size exceeds platform capacity.");
 				vector<Int64> RawValue((size_t)Elements);
 				m_pReader->Read(&(RawValue[0]), Elements);
@@ -725,7 +1484,7 @@ namespace wb
 				if (GetPrimitiveType() != PrimitiveTypes::Array || GetArrayType() != ArrayTypes::Strings) throw CreateDmlException("Cannot read array of a different type.");				
 				if (Options.ArrayCodec == Codecs::NotLoaded) throw CreateDmlException("A codec for the arrays primitive set has not been loaded by the DML stream.");				
 
-				UInt64 NStrings = m_pReader->ReadCompact64();
+				UInt64 NStrings = ReadArrayLength();
 				vector<string> Value;
 				for (UInt64 ii = 0; ii < NStrings; ii++)
 				{
@@ -741,6 +1500,113 @@ namespace wb
 				return Value;
 			}
 
+			/** Get..(): Array Primitives Into Caller Storage **/
+
+			/// <summary>
+			/// GetArrayLength() returns the number of elements in the current array node, or the number of strings in a string 
+			/// array, without retrieving its content.  The node remains open for one of the Get..() calls, which can then read 
+			/// the content into storage of the right size.
+			/// </summary>
+			UInt64 GetArrayLength()
+			{
+				if (GetPrimitiveType() != PrimitiveTypes::Array) throw CreateDmlException("Node type does not match Get..() type.");
+				return PeekArrayLength();
+			}
+
+			/// <summary>Retrieves the value of an array node into Value, reusing its capacity.  Reading a series of arrays into the
+			/// same vector requires no allocation once it has grown to the largest of them.</summary>
+			void GetInto(vector<byte>& Value) { GetTemplateArray<byte>(ArrayTypes::U8, Value); }
+			void GetInto(vector<UInt16>& Value) { GetTemplateArray<UInt16>(ArrayTypes::U16, Value); }
+			void GetInto(vector<UInt32>& Value) { GetTemplateArray<UInt32>(ArrayTypes::U32, Value); }
+			void GetInto(vector<UInt64>& Value) { GetTemplateArray<UInt64>(ArrayTypes::U64, Value); }
+			void GetInto(vector<char>& Value) { GetTemplateArray<char>(ArrayTypes::I8, Value); }
+			void GetInto(vector<Int16>& Value) { GetTemplateArray<Int16>(ArrayTypes::I16, Value); }
+			void GetInto(vector<Int32>& Value) { GetTemplateArray<Int32>(ArrayTypes::I32, Value); }
+			void GetInto(vector<Int64>& Value) { GetTemplateArray<Int64>(ArrayTypes::I64, Value); }
+			void GetInto(vector<float>& Value) { GetTemplateArray<float>(ArrayTypes::Singles, Value); }
+			void GetInto(vector<double>& Value) { GetTemplateArray<double>(ArrayTypes::Doubles, Value); }
+
+			/// <summary>Retrieves the value of a DateTime array node into Value, reusing its capacity.</summary>
+			void GetInto(vector<DateTime>& Value)
+			{
+				if (GetPrimitiveType() != PrimitiveTypes::Array || GetArrayType() != ArrayTypes::DateTimes) throw CreateDmlException("Cannot read array of a different type.");
+				if (Options.ArrayCodec == Codecs::NotLoaded) throw CreateDmlException("A codec for the arrays primitive set has not been loaded by the DML stream.");
+				m_pReader->IsLittleEndian = (Options.ArrayCodec == Codecs::LE);
+
+				UInt64 Elements = ReadArrayLength();
+				if (Elements > size_t_MaxValue) throw CreateDmlException("Array size exceeds platform capacity.");
+				Value.resize((size_t)Elements);
+				if (Elements > 0) ReadDateTimeContent(&(Value[0]), Elements);
+				m_pAssociation = nullptr;
+			}
+
+			/// <summary>Retrieves the value of a string array node into Value, reusing both the vector and the storage of the strings
+			/// already in it.</summary>
+			void GetInto(vector<string>& Value)
+			{
+				if (GetPrimitiveType() != PrimitiveTypes::Array || GetArrayType() != ArrayTypes::Strings) throw CreateDmlException("Cannot read array of a different type.");				
+				if (Options.ArrayCodec == Codecs::NotLoaded) throw CreateDmlException("A codec for the arrays primitive set has not been loaded by the DML stream.");				
+
+				UInt64 NStrings = ReadArrayLength();
+				if (NStrings > size_t_MaxValue) throw CreateDmlException("Array size exceeds platform capacity.");
+				Value.resize((size_t)NStrings);
+				for (size_t ii = 0; ii < Value.size(); ii++)
+				{
+					UInt64 NBytes = m_pReader->ReadCompact64();
+					if (NBytes > (UInt32)Int32_MaxValue) throw CreateDmlException("String exceeds maximum supported length.");
+					Value[ii].resize((UInt32)NBytes);
+					if (NBytes > 0) m_pReader->Read(&(Value[ii][0]), NBytes);
+				}
+				m_pAssociation = nullptr;
+			}
+
+			/// <summary>Retrieves the value of an array node into pValue, which has room for Capacity elements.  If the array is 
+			/// larger, an exception is thrown and the node remains open, so that the array can be retrieved with a larger buffer.
+			/// See GetArrayLength().</summary>
+			/// <returns>The number of elements retrieved.</returns>
+			size_t GetByteArray(byte* pValue, size_t Capacity) { return GetTemplateArray<byte>(ArrayTypes::U8, pValue, Capacity); }
+
+			/// <summary>Retrieves the value of an array node into pValue.  See GetByteArray(byte*, size_t).</summary>
+			size_t GetUInt16Array(UInt16* pValue, size_t Capacity) { return GetTemplateArray<UInt16>(ArrayTypes::U16, pValue, Capacity); }
+
+			/// <summary>Retrieves the value of an array node into pValue.  See GetByteArray(byte*, size_t).</summary>
+			size_t GetUInt32Array(UInt32* pValue, size_t Capacity) { return GetTemplateArray<UInt32>(ArrayTypes::U32, pValue, Capacity); }
+
+			/// <summary>Retrieves the value of an array node into pValue.  See GetByteArray(byte*, size_t).</summary>
+			size_t GetUInt64Array(UInt64* pValue, size_t Capacity) { return GetTemplateArray<UInt64>(ArrayTypes::U64, pValue, Capacity); }
+
+			/// <summary>Retrieves the value of an array node into pValue.  See GetByteArray(byte*, size_t).</summary>
+			size_t GetInt8Array(char* pValue, size_t Capacity) { return GetTemplateArray<char>(ArrayTypes::I8, pValue, Capacity); }
+
+			/// <summary>Retrieves the value of an array node into pValue.  See GetByteArray(byte*, size_t).</summary>
+			size_t GetInt16Array(Int16* pValue, size_t Capacity) { return GetTemplateArray<Int16>(ArrayTypes::I16, pValue, Capacity); }
+
+			/// <summary>Retrieves the value of an array node into pValue.  See GetByteArray(byte*, size_t).</summary>
+			size_t GetInt32Array(Int32* pValue, size_t Capacity) { return GetTemplateArray<Int32>(ArrayTypes::I32, pValue, Capacity); }
+
+			/// <summary>Retrieves the value of an array node into pValue.  See GetByteArray(byte*, size_t).</summary>
+			size_t GetInt64Array(Int64* pValue, size_t Capacity) { return GetTemplateArray<Int64>(ArrayTypes::I64, pValue, Capacity); }
+
+			/// <summary>Retrieves the value of an array node into pValue.  See GetByteArray(byte*, size_t).</summary>
+			size_t GetSingleArray(float* pValue, size_t Capacity) { return GetTemplateArray<float>(ArrayTypes::Singles, pValue, Capacity); }
+
+			/// <summary>Retrieves the value of an array node into pValue.  See GetByteArray(byte*, size_t).</summary>
+			size_t GetDoubleArray(double* pValue, size_t Capacity) { return GetTemplateArray<double>(ArrayTypes::Doubles, pValue, Capacity); }
+
+			/// <summary>Retrieves the value of a DateTime array node into pValue.  See GetByteArray(byte*, size_t).</summary>
+			size_t GetDateTimeArray(DateTime* pValue, size_t Capacity)
+			{
+				if (GetPrimitiveType() != PrimitiveTypes::Array || GetArrayType() != ArrayTypes::DateTimes) throw CreateDmlException("Cannot read array of a different type.");
+				if (Options.ArrayCodec == Codecs::NotLoaded) throw CreateDmlException("A codec for the arrays primitive set has not been loaded by the DML stream.");
+				m_pReader->IsLittleEndian = (Options.ArrayCodec == Codecs::LE);
+
+				if (PeekArrayLength() > Capacity) throw CreateDmlException("Array does not fit in the buffer provided.  See GetArrayLength().");
+				UInt64 Elements = ReadArrayLength();
+				ReadDateTimeContent(pValue, Elements);
+				m_pAssociation = nullptr;
+				return (size_t)Elements;
+			}
+
 			/** Get..(): Matrix Primitives **/
 
 			/// <summary>Retrieves the value of a matrix node.</summary>
@@ -783,6 +1649,143 @@ namespace wb
 			/// <returns>Data content</returns>
 			matrix<double> GetDoubleMatrix() { return GetTemplateMatrix<double>(ArrayTypes::Doubles); }
 
+			/** Get..View(): Array and Matrix Primitives In Place **/
+
+			/// <summary>
+			/// CanGetView() indicates whether the current array or matrix node can be retrieved in place, without allocation or
+			/// copying, through one of the Get...View() calls.  This requires a stream that supports direct reads (such as a
+			/// MemoryStream or MappedFileStream) and, for multi-byte elements, an array codec matching the platform byte order and
+			/// content that is aligned for the element type.  The content follows variable-length headers, so unless the document 
+			/// was written with DmlWriter::AlignArrays set, its alignment varies from node to node; when CanGetView() returns false, 
+			/// use the Get...Array() form instead.  The views returned remain valid only as long as the stream they refer to.
+			/// </summary>
+			bool CanGetView()
+			{
+				if (GetPrimitiveType() != PrimitiveTypes::Array && GetPrimitiveType() != PrimitiveTypes::Matrix) return false;
+				if (!m_pReader->m_pStream->CanReadDirect()) return false;
+				switch (GetArrayType())
+				{
+				case ArrayTypes::U8: 
+				case ArrayTypes::I8: return true;
+				case ArrayTypes::U16: case ArrayTypes::U32: case ArrayTypes::U64:
+				case ArrayTypes::I16: case ArrayTypes::I32: case ArrayTypes::I64:
+				case ArrayTypes::Singles: case ArrayTypes::Doubles:
+					if (Options.ArrayCodec == Codecs::NotLoaded) return false;
+					m_pReader->IsLittleEndian = (Options.ArrayCodec == Codecs::LE);
+					if (!m_pReader->IsNativeOrder()) return false;
+					break;
+				default: return false;
+				}
+				switch (GetArrayType())
+				{
+				case ArrayTypes::U16: return IsContentAligned(alignof(UInt16));
+				case ArrayTypes::U32: return IsContentAligned(alignof(UInt32));
+				case ArrayTypes::U64: return IsContentAligned(alignof(UInt64));
+				case ArrayTypes::I16: return IsContentAligned(alignof(Int16));
+				case ArrayTypes::I32: return IsContentAligned(alignof(Int32));
+				case ArrayTypes::I64: return IsContentAligned(alignof(Int64));
+				case ArrayTypes::Singles: return IsContentAligned(alignof(float));
+				default: return IsContentAligned(alignof(double));
+				}
+			}
+
+			/// <summary>Retrieves the value of an array node in place.  See CanGetView().</summary>
+			array_view<byte> GetByteArrayView() { return GetTemplateArrayView<byte>(ArrayTypes::U8); }
+
+			/// <summary>Retrieves the value of an array node in place.  See CanGetView().</summary>
+			array_view<UInt16> GetUInt16ArrayView() { return GetTemplateArrayView<UInt16>(ArrayTypes::U16); }
+
+			/// <summary>Retrieves the value of an array node in place.  See CanGetView().</summary>
+			array_view<UInt32> GetUInt32ArrayView() { return GetTemplateArrayView<UInt32>(ArrayTypes::U32); }
+
+			/// <summary>Retrieves the value of an array node in place.  See CanGetView().</summary>
+			array_view<UInt64> GetUInt64ArrayView() { return GetTemplateArrayView<UInt64>(ArrayTypes::U64); }
+
+			/// <summary>Retrieves the value of an array node in place.  See CanGetView().</summary>
+			array_view<char> GetInt8ArrayView() { return GetTemplateArrayView<char>(ArrayTypes::I8); }
+
+			/// <summary>Retrieves the value of an array node in place.  See CanGetView().</summary>
+			array_view<Int16> GetInt16ArrayView() { return GetTemplateArrayView<Int16>(ArrayTypes::I16); }
+
+			/// <summary>Retrieves the value of an array node in place.  See CanGetView().</summary>
+			array_view<Int32> GetInt32ArrayView() { return GetTemplateArrayView<Int32>(ArrayTypes::I32); }
+
+			/// <summary>Retrieves the value of an array node in place.  See CanGetView().</summary>
+			array_view<Int64> GetInt64ArrayView() { return GetTemplateArrayView<Int64>(ArrayTypes::I64); }
+
+			/// <summary>Retrieves the value of an array node in place.  See CanGetView().</summary>
+			array_view<float> GetSingleArrayView() { return GetTemplateArrayView<float>(ArrayTypes::Singles); }
+
+			/// <summary>Retrieves the value of an array node in place.  See CanGetView().</summary>
+			array_view<double> GetDoubleArrayView() { return GetTemplateArrayView<double>(ArrayTypes::Doubles); }
+
+			/// <summary>Retrieves the value of a matrix node in place.  See CanGetView().</summary>
+			matrix_view<UInt8> GetUInt8MatrixView() { return GetTemplateMatrixView<UInt8>(ArrayTypes::U8); }
+
+			/// <summary>Retrieves the value of a matrix node in place.  See CanGetView().</summary>
+			matrix_view<UInt16> GetUInt16MatrixView() { return GetTemplateMatrixView<UInt16>(ArrayTypes::U16); }
+
+			/// <summary>Retrieves the value of a matrix node in place.  See CanGetView().</summary>
+			matrix_view<UInt32> GetUInt32MatrixView() { return GetTemplateMatrixView<UInt32>(ArrayTypes::U32); }
+
+			/// <summary>Retrieves the value of a matrix node in place.  See CanGetView().</summary>
+			matrix_view<UInt64> GetUInt64MatrixView() { return GetTemplateMatrixView<UInt64>(ArrayTypes::U64); }
+
+			/// <summary>Retrieves the value of a matrix node in place.  See CanGetView().</summary>
+			matrix_view<char> GetInt8MatrixView() { return GetTemplateMatrixView<char>(ArrayTypes::I8); }
+
+			/// <summary>Retrieves the value of a matrix node in place.  See CanGetView().</summary>
+			matrix_view<Int16> GetInt16MatrixView() { return GetTemplateMatrixView<Int16>(ArrayTypes::I16); }
+
+			/// <summary>Retrieves the value of a matrix node in place.  See CanGetView().</summary>
+			matrix_view<Int32> GetInt32MatrixView() { return GetTemplateMatrixView<Int32>(ArrayTypes::I32); }
+
+			/// <summary>Retrieves the value of a matrix node in place.  See CanGetView().</summary>
+			matrix_view<Int64> GetInt64MatrixView() { return GetTemplateMatrixView<Int64>(ArrayTypes::I64); }
+
+			/// <summary>Retrieves the value of a matrix node in place.  See CanGetView().</summary>
+			matrix_view<float> GetSingleMatrixView() { return GetTemplateMatrixView<float>(ArrayTypes::Singles); }
+
+			/// <summary>Retrieves the value of a matrix node in place.  See CanGetView().</summary>
+			matrix_view<double> GetDoubleMatrixView() { return GetTemplateMatrixView<double>(ArrayTypes::Doubles); }
+
+			#pragma endregion
+
+			#pragma region "Accept()"
+
+			/// <summary>
+			/// Accept() reads the remainder of the document, or of the current container and everything after it, and passes each
+			/// node to the matching handler of Visitor.  See DmlVisitor for the handlers.  Each node is decoded once, directly into
+			/// the handler's arguments, without the type checks of the Get..() calls.  This is the fastest way to read an entire
+			/// document, for example to convert it to another form.  Padding, and primitives of types the reader does not support,
+			/// are skipped.
+			/// </summary>
+			template <class Visitor> void Accept(Visitor& V)
+			{
+				string Text;						// Reused for each string and comment node.
+				while (Read())
+				{
+					switch (m_pAssociation->NodeType)
+					{
+					case NodeTypes::Container: V.OnContainer(*m_pAssociation); continue;
+					case NodeTypes::EndAttributes: V.OnEndAttributes(); continue;
+					case NodeTypes::EndContainer: V.OnEndContainer(*m_pContainer->m_pAssociation); continue;
+					case NodeTypes::Comment:
+						{
+							UInt64 Length = m_pReader->ReadCompact64();
+							if (Length > Int32_MaxValue) throw CreateDmlException("Strings longer than 2^32 are not supported.");
+							Text.resize((size_t)Length);
+							if (Length > 0) m_pReader->Read(&(Text[0]), (Int64)Length);
+							m_pAssociation = nullptr;
+							V.OnComment(Text);
+							continue;
+						}
+					case NodeTypes::Primitive: AcceptPrimitive(V, Text); continue;
+					default: continue;
+					}
+				}
+			}
+
 			#pragma endregion
 
 			#pragma region "GetAs...() primitives with conversion"
@@ -935,45 +1938,76 @@ namespace wb
 
 			/// <summary>
 			/// CanSeek checks whether the underlying stream is capable of seeking.  If the stream can seek,
-			/// the MoveOutOfContainer() operation is fast and the GetContext() and Seek...() methods are
-			/// available.  If the stream cannot seek, the MoveOutOfContainer() operation is slower and the
+			/// the SkipContainer() operation is fast and the GetContext() and Seek...() methods are
+			/// available.  If the stream cannot seek, the SkipContainer() operation is slower and the
 			/// GetContext() and Seek...() methods will result in an exception.
 			/// </summary>
 			bool CanSeek() { return m_pReader->m_pStream->CanSeek(); }
 
 			DmlContext* GetContainer() { return m_pContainer; }
 
-			#if 0		// Should probably be avoided in this form now that ContentSize is a bit of a higher-level behavior.
 			/// <summary>
-			/// MoveOutOfContainer() permits the caller to navigate the reader out of the present container.
-			/// In the case of a seekable, fixed-length container, this operation is very fast.  In other
-			/// cases, the operation can be time consuming.
+			/// SkipContainer() passes over the remainder of the current container, leaving its EndContainer marker as the current 
+			/// node.  It can be called upon reading the Container node or at any point within the container.  If the container 
+			/// has a DML:ContentSize attribute, its elements are not parsed: on a seekable stream, the reader seeks directly to the
+			/// end of the container, and on other streams the elements are discarded in bulk if none have been read yet.  Without
+			/// a ContentSize, the remaining nodes are read and discarded, and nested containers are skipped in the same manner.
 			/// </summary>
-			/// <seealso>GetContainer->IsSizeKnown()</seealso>
-			void MoveOutOfContainer()
+			/// <seealso>DmlContext::IsContentSizeKnown()</seealso>
+			void SkipContainer()
 			{
-				if (m_pContainer->DataSize == UInt64_MaxValue || !m_pReader->m_pStream->CanSeek())
+				if (m_pContainer == nullptr || m_pContainer->OutOfBand) throw CreateDmlException("No container is open to be skipped.");
+				DmlContext* pTarget = m_pContainer;
+				if (m_pAssociation != nullptr && GetNodeType() == NodeTypes::EndContainer) return;
+				bool AtElements = (m_pAssociation != nullptr && GetNodeType() == NodeTypes::EndAttributes);
+
+				// The ContentSize is an attribute, so any remaining attributes are read to find it.
+				while (IsAttribute && !AtElements)
 				{
-					// We can parse until we see the end container marker.  We may also see sub-containers
-					// within this one, so we have to keep track of what container it is we intend to close.
-					DmlContext* pToFinish = m_pContainer;
-					while (Read())
+					if (!Read()) throw CreateDmlException("Unterminated container.");
+					switch (GetNodeType())
 					{
-						if (GetNodeType() == NodeTypes::EndContainer && m_pContainer == pToFinish) return;
+					case NodeTypes::EndContainer: return;
+					case NodeTypes::EndAttributes: AtElements = true; continue;
+					case NodeTypes::Container: SkipContainer(); continue;
+					case NodeTypes::Primitive: if (GetID() == dmltsl::dml3::idDMLContentSize && GetPrimitiveType() == PrimitiveTypes::UInt) GetUInt(); continue;
+					default: continue;
 					}
 				}
-				else
+
+				if (pTarget->IsContentSizeKnown())
 				{
-					FinishNode();
-					if (m_pContainer == nullptr || m_pContainer->OutOfBand) throw CreateDmlException("Mismatch between opening and closing of containers.");
-					m_pReader->m_pStream->Seek(m_pContainer->StartPosition + (Int64)m_pContainer->DataSize, SeekOrigin::Begin);
-					DmlContext* pParent = m_pContainer->m_pContainer;
-					delete m_pContainer;
-					m_pContainer = pParent;
-					m_pAssociation = nullptr;
+					if (pTarget->ElementsPosition != Int64_MaxValue)
+					{
+						FinishNode();
+						Int64 Position = pTarget->ElementsPosition + (Int64)pTarget->ContentSize;
+						m_pReader->Seek(Position, SeekOrigin::Begin);
+						AdviseSeek(Position);
+					}
+					else if (AtElements)
+					{
+						FinishNode();
+						DiscardBytes(pTarget->ContentSize);
+					}
+					if (pTarget->ElementsPosition != Int64_MaxValue || AtElements)
+					{
+						if (!Read() || GetNodeType() != NodeTypes::EndContainer || m_pContainer != pTarget) 
+							throw CreateDmlException("Invalid ContentSize indicator, missing End-Container marker, or incomplete structure.");
+						return;
+					}
+				}
+
+				for (; ; )
+				{
+					if (!Read()) throw CreateDmlException("Unterminated container.");
+					switch (GetNodeType())
+					{
+					case NodeTypes::EndContainer: if (m_pContainer == pTarget) return; continue;
+					case NodeTypes::Container: SkipContainer(); continue;
+					default: continue;
+					}
 				}
 			}
-			#endif
 
 			/// <summary>
 			/// GetContext() is used with seekable streams in order to navigate.  The returned DmlContext
@@ -983,10 +2017,14 @@ namespace wb
 			/// identifies the current container and all higher-level containers in the tree.
 			/// </summary>
 			/// <returns>A DmlContext that can be used with the Seek..() methods.</returns>
+			/// <remarks>The returned context shares the reader's parent contexts and associations, so the cost does not depend on
+			/// the depth or the translations in effect.  It remains valid after the reader leaves the container, for as long as the
+			/// DmlReader exists.</remarks>
 			DmlContext GetContext() {
 				FinishNode();
-				DmlContext ret(*m_pContainer);
-				ret.ContextPosition = m_pReader->m_pStream->GetPosition();
+				DmlContext ret;
+				if (m_pContainer != nullptr) ret.Assign(*m_pContainer);
+				ret.ContextPosition = m_pReader->GetPosition();
 				return ret;
 			}
 
@@ -1016,29 +2054,24 @@ namespace wb
 			void SeekAbsolute(const DmlContext& Context, UInt64 Position)
 			{
 				FinishNode();           // Clear out the current Association so it does not linger at the new location.
-				m_pReader->m_pStream->Seek((Int64)Position, SeekOrigin::Begin);
-
-				// Responsibility for freeing the m_pContainer object and any parent objects lies with DmlReader.  However,
-				// portions of the container may be shared by the new context, therefore caution is required.  If there is a
-				// common pointer value anywhere in the chain, then they must be pointing to the same place and the remainder
-				// up the chain is identical - at that stage no further objects need be deleted.
-				DmlContext* pOld = m_pContainer;				
-				while (pOld != nullptr)
+				m_pReader->Seek((Int64)Position, SeekOrigin::Begin);
+				AdviseSeek((Int64)Position);
+
+				// Portions of the old chain may be shared by the new context, so the new context takes its references before the
+				// reader's reference to the old chain is released.
+				DmlContext* pOld = m_pContainer;
+				if (Context.m_pAssociation.IsAssigned())
 				{
-					bool Retain = false;
-					DmlContext* pNew = m_pContainer;
-					while (pNew != nullptr)
-					{
-						if (pNew == pOld) { Retain = true; break; }
-						pNew = pNew->m_pContainer;
-					}
-					if (Retain) break;
-					DmlContext* pOldParent = pOld->m_pContainer;
-					delete pOld;
-					pOld = pOldParent;
+					m_pContainer = NewContext();
+					m_pContainer->Assign(Context);
 				}
-
-				m_pContainer = new DmlContext(Context);
+				else
+				{
+					// A context taken at the top level of the document.
+					m_pContainer = Context.m_pContainer;
+					if (m_pContainer != nullptr) m_pContainer->References++;
+				}
+				ReleaseContext(pOld);
 			}
 
 			/// <summary>
@@ -1076,7 +2109,8 @@ namespace wb
 			{
 				FinishNode();           // Clear out the current Association so it does not linger at the new location.
 				DmlContext ret = GetContext();
-				m_pReader->m_pStream->Seek((Int64)Position, SeekOrigin::Begin);
+				m_pReader->Seek((Int64)Position, SeekOrigin::Begin);
+				AdviseSeek((Int64)Position);
 				
 				m_pContainer->OutOfBand = true;
 				return ret;
@@ -1232,23 +2266,6 @@ namespace wb
 				delete pDoc;
 			}
 
-			/// <summary>Reads until an EndContainer marker is found.  If additional Container markers are found, recurses
-			/// such that they are also skipped.</summary>
-			void SkipContainer(DmlReader& Reader)
-			{
-				for (; ; )
-				{
-					if (!Reader.Read()) throw Reader.CreateDmlException("Unterminated container.");
-
-					switch (Reader.GetNodeType())
-					{
-					case NodeTypes::EndContainer: return;
-					case NodeTypes::Container: SkipContainer(Reader); continue;
-					default: continue;
-					}
-				}
-			}
-
 			// Precondition: We must have already parsed the EndAttributes marker of the DML:Header or DML:Translation tag
 			// and be ready to process the container.
 			// Postcondition: Will have processed the EndContainer marker before returning.
@@ -1345,7 +2362,7 @@ namespace wb
 									case NodeTypes::EndContainer: break;
 									case NodeTypes::EndAttributes: 
 										// TODO: Currently, we discard primitive configuration information because extensions are not supported.
-										SkipContainer(Reader); 
+										Reader.SkipContainer(); 
 										break;
 									case NodeTypes::Primitive:
 										switch (Reader.GetID())
@@ -1610,7 +2627,8 @@ namespace wb
 						case NodeTypes::EndContainer:
 							{
 								DmlContext* pParent = m_pContainer->m_pContainer;
-								delete m_pContainer;
+								if (pParent != nullptr) pParent->References++;			// The reader's reference moves to the parent.
+								ReleaseContext(m_pContainer);
 								m_pContainer = pParent;
 								m_pAssociation = nullptr;
 								break;
@@ -1647,7 +2665,7 @@ namespace wb
 			void SkipArray()
 			{
 				if (GetArrayType() == ArrayTypes::Strings) { SkipStringArray(); return; }
-				UInt64 Elements = m_pReader->ReadCompact64();
+				UInt64 Elements = ReadArrayLength();
 				UInt64 ElementSize;
 				switch (GetArrayType())
 				{
@@ -1698,7 +2716,7 @@ namespace wb
 			{
 				if (GetPrimitiveType() != PrimitiveTypes::Array || GetArrayType() != ArrayTypes::Strings) throw CreateDmlException("Cannot read array of a different type.");
             
-				UInt64 NStrings = m_pReader->ReadCompact64();
+				UInt64 NStrings = ReadArrayLength();
 				for (UInt64 ii=0; ii < NStrings; ii++)
 				{
 					UInt64 NBytes = m_pReader->ReadCompact64();					
@@ -1723,18 +2741,11 @@ namespace wb
 
 			/** Translation management **/
 
+			/// <summary>Returns the translation in effect in the current container.  It is resolved when each container is opened and
+			/// kept in its DmlContext, so the cost does not depend on the nesting depth.</summary>
 			Translation* GetActiveTranslation()
 			{
-				if (m_pContainer != nullptr)
-				{
-					if (m_pContainer->m_pAssociation->pLocalTranslation != nullptr) return m_pContainer->m_pAssociation->pLocalTranslation;
-					DmlContext* pIter = m_pContainer->m_pContainer;
-					while (pIter != nullptr)
-					{
-						if (pIter->m_pAssociation->pLocalTranslation != nullptr) return pIter->m_pAssociation->pLocalTranslation;
-						pIter = pIter->m_pContainer;
-					}
-				}
+				if (m_pContainer != nullptr && m_pContainer->ActiveTranslation != nullptr) return m_pContainer->ActiveTranslation;
 				return &GlobalTranslation;
 			}
 
@@ -1748,60 +2759,64 @@ namespace wb
 			{
 				try
 				{
+					// The key is the name length followed by the raw name and type.  m_InlineKey retains its capacity, so that the 
+					// lookup of a repeated identification does not allocate.
 					UInt32 NameLen = m_pReader->ReadCompact32();
-					string Name;
-					Name.resize(NameLen);
-					m_pReader->Read(&Name[0], NameLen);
-
-					UInt32 TypeLen = m_pReader->ReadCompact32();					
-					string Type;
-					Type.resize(TypeLen);
-					m_pReader->Read(&Type[0], TypeLen);					
-
-					if (compare_no_case(Type, "container") == 0)
-					{
-						return r_ptr<Association>::responsible(new Association(dmltsl::dml3::idInlineIdentification, Name, NodeTypes::Container));
-					}
-					else
-					{
-						PrimitiveTypes PrimitiveType; ArrayTypes ArrayType;
-						if (!StringToPrimitiveType(Type, PrimitiveType, ArrayType))
-						{
-							/**
-							foreach (IDmlReaderExtension Ext in Options.Extensions)
-							{
-								uint TypeId = Ext.Identify(Type);
-								if (TypeId != 0)
-									return new Association(DmlTranslation.DML2.InlineIdentification.DMLID, new DmlName(Name, Ext, TypeId));
-							}
-							**/
-							throw CreateDmlException("Dml type not recognized internally or by any registered extensions.");
-						}
-						return r_ptr<Association>::responsible(new Association(dmltsl::dml3::idInlineIdentification, Name, PrimitiveType, ArrayType));
-					}
+					size_t NameStart = sizeof(NameLen);
+					m_InlineKey.resize(NameStart + NameLen);
+					CopyMemory(&m_InlineKey[0], &NameLen, sizeof(NameLen));
+					m_pReader->Read(&m_InlineKey[NameStart], NameLen);
+
+					UInt32 TypeLen = m_pReader->ReadCompact32();
+					size_t TypeStart = NameStart + NameLen;
+					m_InlineKey.resize(TypeStart + TypeLen);
+					m_pReader->Read(&m_InlineKey[TypeStart], TypeLen);
+
+					inline_map_type::iterator Found = m_InlineAssociations.find(m_InlineKey);
+					if (Found != m_InlineAssociations.end()) return r_ptr<Association>::absolved(Found->second);
+
+					r_ptr<Association> pNew = ParseIdentificationInformation(m_InlineKey.substr(NameStart, NameLen), m_InlineKey.substr(TypeStart, TypeLen));
+					if (m_InlineAssociations.size() >= MaxInlineAssociations) return pNew;
+					Association* pInterned = pNew.release();
+					m_InlineAssociations.insert(m_InlineKey, pInterned);
+					return r_ptr<Association>::absolved(pInterned);
 				}
 				catch (std::exception& ex) { throw CreateDmlException(ex.what()); }
 			}
 
-			void DiscardBytes(Stream *pStream, UInt64 NBytes)
+			/// <summary>Creates the Association for an inline identification that was not found in m_InlineAssociations.</summary>
+			r_ptr<Association> ParseIdentificationInformation(const string& Name, const string& Type)
 			{
-				if (pStream->CanSeek()) pStream->Seek((Int64)NBytes, SeekOrigin::Current);
+				if (compare_no_case(Type, "container") == 0)
+				{
+					return r_ptr<Association>::responsible(new Association(dmltsl::dml3::idInlineIdentification, Name, NodeTypes::Container));
+				}
 				else
 				{
-					static const int TrashSize = 4090;
-					byte *pTrash = new byte [TrashSize];
-					while (NBytes > 0)
+					PrimitiveTypes PrimitiveType; ArrayTypes ArrayType;
+					if (!StringToPrimitiveType(Type, PrimitiveType, ArrayType))
 					{
-						int nToRead = TrashSize;
-						if (NBytes < (UInt64)nToRead) nToRead = (int)NBytes;                    
-						Int64 nRead = pStream->Read(pTrash, nToRead);
-						if (nRead < nToRead) throw EndOfStreamException();
-						NBytes -= (UInt64)nRead;
+						/**
+						foreach (IDmlReaderExtension Ext in Options.Extensions)
+						{
+							uint TypeId = Ext.Identify(Type);
+							if (TypeId != 0)
+								return new Association(DmlTranslation.DML2.InlineIdentification.DMLID, new DmlName(Name, Ext, TypeId));
+						}
+						**/
+						throw CreateDmlException("Dml type not recognized internally or by any registered extensions.");
 					}
+					return r_ptr<Association>::responsible(new Association(dmltsl::dml3::idInlineIdentification, Name, PrimitiveType, ArrayType));
 				}
 			}
 
-			void DiscardBytes(UInt64 NBytes) { DiscardBytes(m_pReader->m_pStream.get(), NBytes); }
+			void DiscardBytes(UInt64 NBytes)
+			{
+				// The scratch buffer is needed only for streams that can neither seek nor provide a read window, and is kept for reuse.
+				if (!m_pReader->m_pStream->CanSeek() && m_Scratch.GetSize() == 0) 
+					m_Scratch.Alloc(Options.DiscardBufferSize > 0 ? Options.DiscardBufferSize : 1);
+				m_pReader->Skip(NBytes, (byte*)m_Scratch.At(), (Int64)m_Scratch.GetSize());
+			}
 
 			#pragma endregion
 
@@ -8,6 +8,7 @@
 #include "../Support/Platforms/Platforms.h"
 #include "../Support/Memory Management/Allocation.h"
 #include "../Support/IO/FileStream.h"
+#include "../Support/IO/BufferedStream.h"
 #include "../Support/IO/EndianBinaryWriter.h"
 #include "../Support/DateTime/DateTime.h"
 
@@ -36,6 +37,7 @@ namespace wb
 			{
 				CommonCodec = Codecs::NotLoaded;
 				ArrayCodec = Codecs::NotLoaded;
+				AlignArrays = false;
 			}			
 			
 			static DmlWriter Create(r_ptr<wb::io::Stream>&& Stream, DmlWriter Context)
@@ -44,6 +46,7 @@ namespace wb
 				ret.m_pWriter = r_ptr<BinaryWriter>::responsible(new wb::io::BinaryWriter(std::move(Stream), false));
 				ret.CommonCodec = Context.CommonCodec;
 				ret.ArrayCodec = Context.ArrayCodec;
+				ret.AlignArrays = Context.AlignArrays;
 				return ret;
 			}
 
@@ -65,17 +68,79 @@ namespace wb
 				}
 			}
 
+			/// <summary>NodeHead collects the encoded head of an array or matrix node, including its dimensions, in a stack buffer so
+			/// that the head can be passed to the stream together with the node's payload.  Partial is set when the start of the head
+			/// had to be written to the stream ahead of the remainder.</summary>
+			struct NodeHead
+			{
+				byte	Data[256];
+				int		Length;
+				bool	Partial;
+
+				NodeHead() : Length(0), Partial(false) { }
+				void AddCompact64(UInt64 Value) { Length += BinaryWriter::EncodeCompact64(Data + Length, Value); }
+				void Add(const string& Text) { CopyMemory(Data + Length, Text.c_str(), Text.length()); Length += (int)Text.length(); }
+			};
+
+			/// <summary>Encodes the equivalent of WriteStartNode(ID) into Head.</summary>
+			void StartNode(NodeHead& Head, UInt32 ID)
+			{
+				assert (ID != dmltsl::dml3::idInlineIdentification);		// This overload cannot be used with inline identification.
+				Head.AddCompact64(ID);
+			}
+
+			/// <summary>Encodes the equivalent of WriteStartNode(Name, NodeType) into Head.  A name too long for the head buffer is 
+			/// instead written to the stream immediately, ahead of the remainder of the head.</summary>
+			void StartNode(NodeHead& Head, const string& Name, const string& NodeType)
+			{
+				// Room is left for the three identification lengths and two dimensions that may follow.
+				if (Name.length() + NodeType.length() + 48 > sizeof(Head.Data)) { WriteStartNode(Name, NodeType); Head.Partial = true; return; }
+				Head.AddCompact64(dmltsl::dml3::idInlineIdentification);
+				Head.AddCompact64(Name.length());
+				Head.Add(Name);
+				Head.AddCompact64(NodeType.length());
+				Head.Add(NodeType);
+			}
+
+			/// <summary>Writes padding, if AlignArrays is set, so that content following Head will begin at a stream position that is a 
+			/// multiple of ElementSize.</summary>
+			void AlignContent(const NodeHead& Head, size_t ElementSize)
+			{
+				if (!AlignArrays || ElementSize == 1 || Head.Partial) return;
+				UInt64 ContentPosition = (UInt64)GetPosition() + Head.Length;
+				WriteReservedSpace((ElementSize - ContentPosition % ElementSize) % ElementSize);
+			}
+
+			/// <summary>Writes Head followed by an array or matrix payload in the array codec's byte order.</summary>
+			template<typename T> void WriteNodeData(const NodeHead& Head, const T* pData, Int64 nElements)
+			{
+				m_pWriter->IsLittleEndian = IsLEArray();
+				AlignContent(Head, sizeof(T));
+				m_pWriter->WriteGather(Head.Data, Head.Length, pData, nElements, sizeof(T));
+			}
+
 		public:
 
 			DmlWriter(DmlWriter&& mv)
 				: m_pBase(std::move(mv.m_pBase)), m_pWriter(std::move(mv.m_pWriter)),
-				CommonCodec(mv.CommonCodec), ArrayCodec(mv.ArrayCodec)
+				CommonCodec(mv.CommonCodec), ArrayCodec(mv.ArrayCodec), AlignArrays(mv.AlignArrays)
 			{ }
 
+			/// <summary>
+			/// Set AlignArrays to true to instruct the DmlWriter to precede each array and matrix node with padding as needed so
+			/// that its content begins at a stream position that is a multiple of the element size.  A DmlReader reading the 
+			/// document from memory or a mapped file can then provide every such node in place (see DmlReader::CanGetView()).  
+			/// Readers discard the padding by default.  AlignArrays requires a stream that reports its position, and changes the 
+			/// encoded size of array and matrix nodes by up to 7 bytes, which must be accounted for in any DML:ContentSize or
+			/// reserved space calculated by the caller.  Default is false.
+			/// </summary>
+			bool AlignArrays;
+
 			static DmlWriter Create(string Filename)
 			{
 				DmlWriter ret;
-				ret.m_pBase = r_ptr<Stream>::responsible(new FileStream(Filename.c_str(), FileMode::Create));
+				r_ptr<Stream> pFile = r_ptr<Stream>::responsible(new FileStream(Filename.c_str(), FileMode::Create));
+				ret.m_pBase = r_ptr<Stream>::responsible(new BufferedStream(std::move(pFile)));
 				ret.m_pWriter = r_ptr<BinaryWriter>::responsible(new BinaryWriter(r_ptr<Stream>::absolved(ret.m_pBase), false));
 				return ret;
 			}
@@ -95,6 +160,14 @@ namespace wb
 				m_pBase.release();
 			}
 
+			/// <summary>
+			/// Flush() passes any DML that has been buffered by the writer to the underlying stream and flushes that stream.
+			/// Output written to a file by name is buffered and is otherwise only guaranteed to reach the file on Close() or
+			/// when the DmlWriter is destroyed.  Errors writing buffered output on destruction are not reported, so call Flush() 
+			/// or Close() to observe them.
+			/// </summary>
+			void Flush() { m_pWriter->m_pStream->Flush(); }
+
 			/// <summary>
 			/// Call AddPrimitiveSet() to attempt to enable a primitive set that is required for the DML document to
 			/// be written.  If a primitive set is not supported, an exception will be thrown.  The AddPrimitiveSet()
@@ -385,7 +458,7 @@ namespace wb
 				WriteStartNode(ID); m_pWriter->WriteCompact64(len); m_pWriter->Write(Value, len);
 			}
 			void Write(UInt32 ID, byte* pData, Int64 nLength) {
-				WriteStartNode(ID); m_pWriter->WriteCompact64(nLength); m_pWriter->Write(pData, nLength);
+				NodeHead Head; StartNode(Head, ID); Head.AddCompact64(nLength); m_pWriter->WriteGather(Head.Data, Head.Length, pData, nLength, 1);
 			}			
 
 			/** Base Primitive Writers: By Inline Identification **/			
@@ -407,7 +480,7 @@ namespace wb
 				WriteStartNode(Name, "string"); m_pWriter->WriteCompact64(len); m_pWriter->Write(Value, len);
 			}
 			void Write(string Name, byte* pData, Int64 nLength) {
-				WriteStartNode(Name, "array-U8"); m_pWriter->WriteCompact64(nLength); m_pWriter->Write(pData, nLength);
+				NodeHead Head; StartNode(Head, Name, "array-U8"); Head.AddCompact64(nLength); m_pWriter->WriteGather(Head.Data, Head.Length, pData, nLength, 1);
 			}
 
 			/** Base Primitive Writers: By Association **/
@@ -516,39 +589,44 @@ namespace wb
 			void Write(UInt32 ID, Int16* pArray, Int64 nElements) { Write(ID, (UInt16*)pArray, nElements); }
 			void Write(UInt32 ID, UInt16* pArray, Int64 nElements)
 			{
-				WriteStartNode(ID);
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, ID);
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 
 			void Write(UInt32 ID, Int32* pArray, Int64 nElements) { Write(ID, (UInt32*)pArray, nElements); }
 			void Write(UInt32 ID, UInt32* pArray, Int64 nElements)
 			{
-				WriteStartNode(ID);
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, ID);
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 
 			void Write(UInt32 ID, Int64* pArray, Int64 nElements) { Write(ID, (UInt64*)pArray, nElements); }
 			void Write(UInt32 ID, UInt64* pArray, Int64 nElements)
 			{
-				WriteStartNode(ID);
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, ID);
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 			
 			void Write(UInt32 ID, float* pArray, Int64 nElements)
 			{
-				WriteStartNode(ID);
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, ID);
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 
 			void Write(UInt32 ID, double* pArray, Int64 nElements)
 			{
-				WriteStartNode(ID);
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, ID);
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 
 			void Write(UInt32 ID, DateTime* pArray, int nElements)
@@ -582,57 +660,66 @@ namespace wb
 
 			void Write(string Name, const UInt16* pArray, Int64 nElements)
 			{
-				WriteStartNode(Name, "array-U16");
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, Name, "array-U16");
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 			void Write(string Name, const UInt32* pArray, Int64 nElements)
 			{
-				WriteStartNode(Name, "array-U32");
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, Name, "array-U32");
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 			void Write(string Name, const UInt64* pArray, Int64 nElements)
 			{
-				WriteStartNode(Name, "array-U64");
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, Name, "array-U64");
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 			void Write(string Name, const char* pArray, Int64 nElements)
 			{
-				WriteStartNode(Name, "array-I8");
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, Name, "array-I8");
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 			void Write(string Name, const Int16* pArray, Int64 nElements)
 			{
-				WriteStartNode(Name, "array-I16");
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, Name, "array-I16");
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 			void Write(string Name, const Int32* pArray, Int64 nElements)
 			{
-				WriteStartNode(Name, "array-I32");
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, Name, "array-I32");
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 			void Write(string Name, const Int64* pArray, Int64 nElements)
 			{
-				WriteStartNode(Name, "array-I64");
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, Name, "array-I64");
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 			void Write(string Name, const float* pArray, Int64 nElements)
 			{
-				WriteStartNode(Name, "array-SF");
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, Name, "array-SF");
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 			void Write(string Name, const double* pArray, Int64 nElements)
 			{
-				WriteStartNode(Name, "array-DF");
-				m_pWriter->WriteCompact64(nElements);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pArray, nElements);
+				NodeHead Head;
+				StartNode(Head, Name, "array-DF");
+				Head.AddCompact64(nElements);
+				WriteNodeData(Head, pArray, nElements);
 			}
 			void Write(string Name, const DateTime* pArray, int nElements)
 			{		
@@ -668,34 +755,38 @@ namespace wb
 
 			void Write(UInt32 ID, const byte* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(ID);
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, ID);
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(UInt32 ID, const UInt16* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(ID);
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, ID);
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(UInt32 ID, const UInt32* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(ID);
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, ID);
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(UInt32 ID, const UInt64* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(ID);
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, ID);
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(UInt32 ID, const char* pMatrix, int nRows, int nColumns) { Write(ID, (UInt8*)pMatrix, nRows, nColumns); }			
@@ -705,100 +796,112 @@ namespace wb
 			
 			void Write(UInt32 ID, const float* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(ID);
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, ID);
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(UInt32 ID, const double* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(ID);
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, ID);
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			/** Matrix Writers: By Inline Identification **/
 
 			void Write(string Name, const byte* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(Name, "matrix-U8");
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, Name, "matrix-U8");
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(string Name, const UInt16* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(Name, "matrix-U16");
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, Name, "matrix-U16");
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(string Name, const UInt32* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(Name, "matrix-U32");
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, Name, "matrix-U32");
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(string Name, const UInt64* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(Name, "matrix-U64");
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, Name, "matrix-U64");
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(string Name, const char* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(Name, "matrix-I8");
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, Name, "matrix-I8");
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(string Name, const Int16* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(Name, "matrix-I16");
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, Name, "matrix-I16");
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(string Name, const Int32* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(Name, "matrix-I32");
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, Name, "matrix-I32");
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(string Name, const Int64* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(Name, "matrix-I64");
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, Name, "matrix-I64");
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(string Name, const float* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(Name, "matrix-SF");
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, Name, "matrix-SF");
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			void Write(string Name, const double* pMatrix, int nRows, int nColumns)
 			{
-				WriteStartNode(Name, "matrix-DF");
-				m_pWriter->WriteCompact64(nColumns);
-				m_pWriter->WriteCompact64(nRows);
-				m_pWriter->IsLittleEndian = IsLEArray(); m_pWriter->Write(pMatrix, nRows * nColumns);
+				NodeHead Head;
+				StartNode(Head, Name, "matrix-DF");
+				Head.AddCompact64(nColumns);
+				Head.AddCompact64(nRows);
+				WriteNodeData(Head, pMatrix, (Int64)nRows * nColumns);
 			}
 
 			/** Matrix Writers: By Association **/
@@ -853,21 +956,15 @@ namespace wb
 					m_pWriter->WriteCompact64(DataSize);
 					ReservedSpace -= SizeSize;
 
-					static const int BufferSize = 4090;
-					byte* pBuffer = new byte [BufferSize];
-					try
+					static const int BufferSize = 65536;
+					static const byte Zeros[BufferSize] = { 0 };
+					while (ReservedSpace > 0)
 					{
-						memset(pBuffer, 0, BufferSize);
-						while (ReservedSpace > 0)
-						{
-							UInt64 WriteSize = ReservedSpace;
-							if (WriteSize > (UInt64)BufferSize) WriteSize = BufferSize;
-							m_pWriter->Write(pBuffer, WriteSize);
-							ReservedSpace -= WriteSize;
-						}
+						UInt64 WriteSize = ReservedSpace;
+						if (WriteSize > (UInt64)BufferSize) WriteSize = BufferSize;
+						m_pWriter->Write(Zeros, WriteSize);
+						ReservedSpace -= WriteSize;
 					}
-					catch (std::exception&) { delete[] pBuffer; throw; }
-					delete[] pBuffer;
 				}
 			}
 
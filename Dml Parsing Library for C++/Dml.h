@@ -18,8 +18,10 @@
 #include "Support/Platforms/Platforms.h"
 #include "Support/Platforms/Language.h"
 #include "Support/Platforms/COM.h"
+#include "Support/Platforms/EndianSwap.h"
 #include "Support/Exceptions.h"
 #include "Support/Matrix.h"
+#include "Support/Collections/ArrayView.h"
 #include "Support/Collections/Iterators.h"
 #include "Support/Collections/Pair.h"
 #include "Support/Collections/UnorderedMap.h"
@@ -27,11 +29,19 @@
 #include "Support/DateTime/DateTime.h"
 #include "Support/DateTime/TimeConstants.h"
 #include "Support/DateTime/TimeSpan.h"
+#include "Support/IO/BufferedStream.h"
+#include "Support/IO/BufferViewStream.h"
+#include "Support/IO/ChunkedMemoryStream.h"
 #include "Support/IO/EndianBinaryReader.h"
 #include "Support/IO/EndianBinaryWriter.h"
 #include "Support/IO/FileStream.h"
+#include "Support/IO/InstrumentedStream.h"
+#include "Support/IO/MappedFileStream.h"
 #include "Support/IO/MemoryStream.h"
+#include "Support/IO/PrefetchStream.h"
+#include "Support/IO/SharedFileStream.h"
 #include "Support/IO/Streams.h"
+#include "Support/IO/WriteBehindStream.h"
 #include "Support/Memory Management/Allocation.h"
 #include "Support/Memory Management/Buffer.h"
 #include "Support/Parsing/BaseTypeParsing.h"
@@ -224,6 +234,31 @@ namespace wb
 		}
 		enum_class_end(ArrayTypes);
 
+		/// <summary>ReadStatus is the outcome of a DmlReader Try..() call.</summary>
+		enum_class_start(ReadStatus,int)
+		{
+			Success,
+
+			/// <summary>The end of the document was reached.</summary>
+			EndOfStream,
+
+			/// <summary>No node is open for reading.</summary>
+			NotOpen,
+
+			/// <summary>The open node is not of the requested type.  The node remains open.</summary>
+			TypeMismatch,
+
+			/// <summary>The node requires a primitive set codec that the DML stream has not loaded.  The node remains open.</summary>
+			CodecNotLoaded,
+
+			/// <summary>The node's DMLID has no association in the active translation.</summary>
+			UnknownID,
+
+			/// <summary>The node cannot appear at this point in the document, such as a container end without a matching start.</summary>
+			Misplaced
+		}
+		enum_class_end(ReadStatus);
+
 		const char* PrimitiveTypeToString(PrimitiveTypes Type, ArrayTypes ArrayType);		
 		bool StringToPrimitiveType(string TypeStr, PrimitiveTypes& Type, ArrayTypes& ArrayType);
 
@@ -423,13 +458,92 @@ namespace wb
 			Translation	*pParentTranslation;
 			map_type	ByID;
 
+			/// <summary>DMLIDs below DenseLimit are resolved through a flat table.  Larger DMLIDs fall back to a hash lookup at
+			/// each level of the translation tree.</summary>
+			static const UInt32 DenseLimit = 1024;
+
+			// The compiled lookup form: an array of Association pointers indexed by DMLID, covering [0, m_nDense), in which the
+			// parent translations have already been flattened so that TryFind() resolves a dense DMLID with one indexed load.
+			// Entries are null where no association exists.  Each translation counts its own changes in m_Generation, and the 
+			// table is stale once the sum of the counts up the tree differs from m_CompiledGeneration, so that a change costs 
+			// nothing at the translations beneath it.
+			memory::Buffer	m_Dense;
+			UInt32			m_nDense;
+			bool			m_HasSparse;			// True if this translation or a parent has a DMLID at or above DenseLimit.
+			UInt64			m_Generation;
+			UInt64			m_CompiledGeneration;
+			UInt64			m_SeenGeneration;		// The generation for which m_nLookups is being counted.
+			UInt64			m_nLookups;
+
 			void Clear()
 			{
 				for (auto ii = ByID.begin(); ii != ByID.end(); ii++)
 					delete ii->second;
 				ByID.clear();
+				m_Generation++;
 			}						
 
+			/// <summary>Returns the sum of the change counts of this translation and its parents.</summary>
+			UInt64 GetTreeGeneration() const
+			{
+				UInt64 Generation = 0;
+				for (const Translation* pIter = this; pIter != nullptr; pIter = pIter->pParentTranslation) Generation += pIter->m_Generation;
+				return Generation;
+			}
+
+			/// <summary>Called when the compiled table is stale.  The table is rebuilt only once the tree has gone unchanged for as
+			/// many lookups as it has entries, so that a translation being built, as when a header alternates declarations with
+			/// lookups, is searched directly instead of being recompiled after every addition.</summary>
+			/// <returns>True if the table was rebuilt.</returns>
+			bool TryCompile(UInt64 Generation)
+			{
+				if (Generation != m_SeenGeneration) { m_SeenGeneration = Generation; m_nLookups = 0; }
+				UInt64 nEntries = 0;
+				for (Translation* pIter = this; pIter != nullptr; pIter = pIter->pParentTranslation) nEntries += pIter->ByID.size();
+				if (++m_nLookups <= nEntries) return false;
+				Compile();
+				m_CompiledGeneration = Generation;
+				return true;
+			}
+
+			/// <summary>Builds the compiled lookup table from this translation and its parents.  Where a DMLID appears at more than
+			/// one level, the nearest translation takes precedence, as it does in a search up the tree.</summary>
+			void Compile()
+			{
+				UInt32 nDense = 0;
+				m_HasSparse = false;
+				for (Translation* pIter = this; pIter != nullptr; pIter = pIter->pParentTranslation)
+				{
+					for (auto it = pIter->ByID.begin(); it != pIter->ByID.end(); it++)
+					{
+						if (it->first >= DenseLimit) m_HasSparse = true;
+						else if (it->first >= nDense) nDense = (UInt32)it->first + 1;
+					}
+				}
+
+				m_Dense.Alloc(nDense * sizeof(Association*));
+				Association** pTable = (Association**)m_Dense.At();
+				for (UInt32 ii = 0; ii < nDense; ii++) pTable[ii] = nullptr;
+				for (Translation* pIter = this; pIter != nullptr; pIter = pIter->pParentTranslation)
+				{
+					for (auto it = pIter->ByID.begin(); it != pIter->ByID.end(); it++)
+					{
+						if (it->first < DenseLimit && pTable[it->first] == nullptr) pTable[it->first] = it->second;
+					}
+				}
+				m_nDense = nDense;
+			}
+
+			/// <summary>Searches up the translation tree by hash lookup at each level, for DMLIDs outside the dense table.</summary>
+			bool TryFindSparse(UInt32 DMLID, Association*& pResult)
+			{
+				for (Translation* pIter = this; pIter != nullptr; pIter = pIter->pParentTranslation)
+				{
+					if (pIter->TryGet(DMLID, pResult)) return true;
+				}
+				return false;
+			}
+
 		private:
 			// To avoid confusion about the parent pointer, we do not allow an implicit copy.  The move constructor and operator= move are still available.
 			Translation(const Translation& cp);		// In C++11, could write = delete here instead.
@@ -470,7 +584,8 @@ namespace wb
 
 		public:
 			Translation()
-				: pParentTranslation(nullptr)
+				: pParentTranslation(nullptr), m_nDense(0), m_HasSparse(false), 
+				m_Generation(0), m_CompiledGeneration(UInt64_MaxValue), m_SeenGeneration(UInt64_MaxValue), m_nLookups(0)
 			{
 			}
 
@@ -481,13 +596,30 @@ namespace wb
 			}
 			*/
 			
-			Translation(Translation&& mv) { operator=(std::move(mv)); }			
+			Translation(Translation&& mv) 
+				: m_nDense(0), m_HasSparse(false), 
+				m_Generation(0), m_CompiledGeneration(UInt64_MaxValue), m_SeenGeneration(UInt64_MaxValue), m_nLookups(0)
+			{ 
+				operator=(std::move(mv)); 
+			}			
 
 			Translation& operator=(Translation&& mv)
 			{
 				pParentTranslation = mv.pParentTranslation;
 				ByID = std::move(mv.ByID);
 
+				// The compiled tables hold pointers to the associations, which do not move, so they remain valid.
+				m_Dense = std::move(mv.m_Dense);
+				m_nDense = mv.m_nDense;
+				m_HasSparse = mv.m_HasSparse;
+				m_Generation = mv.m_Generation;
+				m_CompiledGeneration = mv.m_CompiledGeneration;
+				m_SeenGeneration = mv.m_SeenGeneration;
+				m_nLookups = mv.m_nLookups;
+				mv.m_nDense = 0;
+				mv.m_Generation++;
+				mv.m_CompiledGeneration = UInt64_MaxValue;
+
 				// Unfortunately, all of our child translations have a pParentTranslation pointer
 				// targeting mv.  We need to update it.  Not the fastest move operation out there.
 				for (auto it = ByID.begin(); it != ByID.end(); it++)
@@ -571,6 +703,7 @@ namespace wb
 
 				map_type::value_type KeyValuePair(Assoc.DMLID, pCopy);
 				ByID.insert(KeyValuePair);
+				m_Generation++;
 			}
 
 			/// <summary>
@@ -597,11 +730,12 @@ namespace wb
 				map_type::iterator entry = ByID.find(NewDMLID);
 				if (entry != ByID.end())
 					throw new Exception("DML ID is already associated in this translation.");				
-				ByID.erase(DMLID);
 				Association* pAssoc = old_entry->second;
+				ByID.erase(old_entry);
 				pAssoc->DMLID = NewDMLID;				
 				map_type::value_type KeyValuePair(pAssoc->DMLID, pAssoc);
 				ByID.insert(KeyValuePair);
+				m_Generation++;
 			}
 
 			/// <summary>
@@ -627,9 +761,15 @@ namespace wb
 			/// <returns>True if the Translation or its parents contain an association for the given DML ID.</returns>
 			bool TryFind(UInt32 DMLID, Association*& pResult)
 			{
-				if (TryGet(DMLID, pResult)) return true;
-				if (pParentTranslation == nullptr) return false;
-				return pParentTranslation->TryFind(DMLID, pResult);
+				UInt64 Generation = GetTreeGeneration();
+				if (Generation != m_CompiledGeneration && !TryCompile(Generation)) return TryFindSparse(DMLID, pResult);
+				if (DMLID < m_nDense)
+				{
+					pResult = ((Association**)m_Dense.At())[DMLID];
+					return (pResult != nullptr);
+				}
+				if (DMLID < DenseLimit || !m_HasSparse) return false;
+				return TryFindSparse(DMLID, pResult);
 			}
 
 			/*** Builtin/Predefined namespaces ***/
@@ -0,0 +1,94 @@
+/*	ArrayView.h
+	Copyright (C) 2014 by Wiley Black (TheWiley@gmail.com)
+*/
+
+#ifndef __WBArrayView_h__
+#define __WBArrayView_h__
+
+#include <assert.h>
+#include <stddef.h>
+
+namespace wb
+{
+	/// <summary>array_view provides read-only access to a contiguous sequence of elements that is stored elsewhere, such as within
+	/// the memory of a MemoryStream or MappedFileStream.  The array_view does not own or copy its elements and is only valid for
+	/// as long as the storage it refers to.  The storage must be aligned for the element type, since elements are accessed 
+	/// through ordinary references; DmlReader provides views only of aligned content (see DmlReader::CanGetView()), which 
+	/// DmlWriter::AlignArrays guarantees.</summary>
+	template < class T > class array_view
+	{
+	public:
+		typedef T					value_type;
+		typedef const value_type&	const_reference;
+		typedef const value_type*	const_iterator;
+
+	private:
+		const value_type*	m_pData;
+		size_t				m_nSize;
+
+	public:
+
+		array_view() : m_pData(nullptr), m_nSize(0) { }
+		array_view(const value_type* pData, size_t nSize) : m_pData(pData), m_nSize(nSize) { }
+
+		size_t size() const { return m_nSize; }
+		bool empty() const { return m_nSize == 0; }
+		const value_type* data() const { return m_pData; }
+
+		const_iterator begin() const { return m_pData; }
+		const_iterator end() const { return m_pData + m_nSize; }
+
+		const_reference operator[] (size_t ii) const
+		{
+			#ifdef _DEBUG
+			assert (ii < m_nSize);
+			#endif
+			return m_pData[ii];
+		}
+	};
+
+	/// <summary>matrix_view provides read-only access to a row-major matrix, laid out in the same order as wb::matrix, that is
+	/// stored elsewhere.  As with array_view, the matrix_view does not own or copy its elements and is only valid for as long
+	/// as the storage it refers to.</summary>
+	template < class T > class matrix_view
+	{
+	public:
+		typedef T					value_type;
+		typedef const value_type&	const_reference;
+
+	private:
+		const value_type*	m_pData;
+		size_t				m_nRows;
+		size_t				m_nColumns;
+
+	public:
+
+		matrix_view() : m_pData(nullptr), m_nRows(0), m_nColumns(0) { }
+		matrix_view(const value_type* pData, size_t rows, size_t columns) : m_pData(pData), m_nRows(rows), m_nColumns(columns) { }
+
+		size_t size() const { return m_nRows * m_nColumns; }
+		size_t rows() const { return m_nRows; }
+		size_t columns() const { return m_nColumns; }
+		const value_type* data() const { return m_pData; }
+
+		const_reference at (size_t iRow, size_t iCol) const
+		{
+			#ifdef _DEBUG
+			assert (iRow < m_nRows && iCol < m_nColumns);
+			#endif
+			return m_pData[(iRow * m_nColumns) + iCol];
+		}
+
+		const_reference operator() (size_t iRow, size_t iCol) const
+		{
+			#ifdef _DEBUG
+			assert (iRow < m_nRows && iCol < m_nColumns);
+			#endif
+			return m_pData[(iRow * m_nColumns) + iCol];
+		}
+	};
+}
+
+#endif	// __WBArrayView_h__
+
+//	End of ArrayView.h
@@ -0,0 +1,125 @@
+/*	BufferViewStream.h
+	Copyright (C) 2014 by Wiley Black (TheWiley@gmail.com)
+*/
+
+#ifndef __WBBufferViewStream_h__
+#define __WBBufferViewStream_h__
+
+#include "Streams.h"
+
+namespace wb
+{
+	namespace io
+	{
+		/// <summary>BufferViewStream implements the abstract Stream class for read-only access to a block of memory owned by the
+		/// caller, such as a received message.  The memory is neither copied nor freed by the stream and must remain valid and
+		/// unchanged while the stream is in use.  Reads, seeks, and position queries are pointer arithmetic on the caller's buffer,
+		/// and the content can be accessed in place through ReadDirect() or GetDirectAccess(), in the same manner as
+		/// MemoryStream.</summary>
+		class BufferViewStream : public Stream
+		{
+			const byte*	m_pView;
+			Int64		m_nLength;
+			Int64		m_iPosition;
+
+		public:
+
+			BufferViewStream()
+			{
+				m_pView = nullptr;
+				m_nLength = m_iPosition = 0;
+			}
+
+			BufferViewStream(const void* pBuffer, size_t nLength)
+			{
+				if (pBuffer == nullptr && nLength > 0) throw ArgumentNullException(S("Null buffer."));
+				m_pView = (const byte*)pBuffer;
+				m_nLength = (Int64)nLength;
+				m_iPosition = 0;
+			}
+
+			BufferViewStream(const BufferViewStream& /*cp*/) { throw Exception("Cannot copy a BufferViewStream object."); }
+			BufferViewStream& operator=(const BufferViewStream& /*cp*/) { throw Exception("Cannot copy a BufferViewStream object."); }
+
+			/// <summary>Attaches the stream to a different buffer and rewinds it, so that one stream object can be reused across
+			/// many messages.</summary>
+			void Reset(const void* pBuffer, size_t nLength)
+			{
+				if (pBuffer == nullptr && nLength > 0) throw ArgumentNullException(S("Null buffer."));
+				m_pView = (const byte*)pBuffer;
+				m_nLength = (Int64)nLength;
+				m_iPosition = 0;
+			}
+
+			bool CanRead() override { return true; }
+			bool CanWrite() override { return false; }
+			bool CanSeek() override { return true; }
+
+			/// <summary>Reads one byte from the stream and advances to the next byte position, or returns -1 if at the end of stream.</summary>
+			int ReadByte() override
+			{
+				if (m_iPosition >= m_nLength) return -1;
+				return m_pView[m_iPosition++];
+			}
+
+			Int64 Read(void* pBuffer, Int64 nLength) override
+			{
+				Int64 Available = m_nLength - m_iPosition;
+				if (Available <= 0) return 0;
+				if (nLength > Available) nLength = Available;
+				CopyMemory(pBuffer, m_pView + m_iPosition, (size_t)nLength);
+				m_iPosition += nLength;
+				return nLength;
+			}
+
+			bool CanReadDirect() override { return true; }
+			const byte* ReadDirect(Int64 nLength) override
+			{
+				if (nLength < 0 || m_iPosition + nLength > m_nLength) return nullptr;
+				const byte* ret = m_pView + m_iPosition;
+				m_iPosition += nLength;
+				return ret;
+			}
+
+			const byte* GetReadWindow(Int64& nAvailable) override
+			{
+				nAvailable = (m_iPosition < m_nLength) ? (m_nLength - m_iPosition) : 0;
+				return m_pView + m_iPosition;
+			}
+			void AdvanceReadWindow(Int64 nBytes) override { m_iPosition += nBytes; }
+
+			Int64 GetPosition() const override { return m_iPosition; }
+			Int64 GetLength() const override { return m_nLength; }
+
+			void Seek(Int64 offset, SeekOrigin origin) override
+			{
+				Int64 Target;
+				switch (origin)
+				{
+				case SeekOrigin::Begin: Target = offset; break;
+				case SeekOrigin::Current: Target = m_iPosition + offset; break;
+				case SeekOrigin::End: Target = m_nLength + offset; break;
+				default: throw ArgumentException(S("Invalid origin."));
+				}
+				if (Target < 0) throw IOException(S("Attempted to seek before the beginning of the stream."));
+				m_iPosition = Target;
+			}
+
+			void Close() override
+			{
+				m_pView = nullptr;
+				m_nLength = m_iPosition = 0;
+			}
+
+			void Rewind() { m_iPosition = 0; }
+
+			/** Retrieves a pointer into the caller's buffer at the current position, or at a specified position **/
+			const byte* GetDirectAccess() const { return m_pView + m_iPosition; }
+			const byte* GetDirectAccess(UInt64 AtPosition) const { return m_pView + AtPosition; }
+		};
+	}
+}
+
+#endif	// __WBBufferViewStream_h__
+
+//	End of BufferViewStream.h
@@ -0,0 +1,295 @@
+/*	BufferedStream.h
+	Copyright (C) 2014 by Wiley Black (TheWiley@gmail.com)
+*/
+
+#ifndef __WBBufferedStream_h__
+#define __WBBufferedStream_h__
+
+#include "Streams.h"
+#include "../Memory Management/Allocation.h"
+#include "../Memory Management/Buffer.h"
+
+namespace wb
+{
+	namespace io
+	{
+		/// <summary>BufferedStream adds a buffering layer on top of another stream so that small reads and writes, such as ReadByte()
+		/// and WriteByte(), are served from memory instead of each resulting in a call on the underlying stream (for a FileStream, a
+		/// system call).  A single buffer is used for either reading or writing at any one time.  Position and seek operations 
+		/// remain consistent with the bytes that have actually been consumed from or written to the buffer, and seeks that land 
+		/// within the read buffer are performed without touching the underlying stream.  Buffered writes are passed to the 
+		/// underlying stream when the buffer fills, and on Flush(), Seek(), Close(), destruction, or a switch to reading.  An error
+		/// in passing writes to the underlying stream on destruction cannot be reported, so call Flush() or Close() first to 
+		/// observe write errors.  While wrapped, the underlying stream should not be accessed directly as its position does not 
+		/// track the BufferedStream's position.  The BufferedStream class is modeled after the .NET System.IO.BufferedStream 
+		/// class.</summary>
+		class BufferedStream : public Stream
+		{
+			memory::r_ptr<Stream>	m_pBase;
+			memory::Buffer			m_Buffer;
+
+			// Bytes [m_iRead, m_nRead) of m_Buffer have been read from the base stream but not yet consumed.
+			UInt32	m_iRead;
+			UInt32	m_nRead;
+
+			// Bytes [0, m_nWrite) of m_Buffer have been written by the caller but not yet passed to the base stream.
+			UInt32	m_nWrite;
+
+			// Position of the base stream, which corresponds to the end of the read buffer or the start of the write
+			// buffer.  Int64_MaxValue if not yet known.
+			mutable Int64	m_BasePosition;
+
+			bool FillReadBuffer()
+			{
+				m_iRead = 0;
+				m_nRead = (UInt32)m_pBase->Read(m_Buffer.At(), m_Buffer.GetSize());
+				if (m_BasePosition != Int64_MaxValue) m_BasePosition += m_nRead;
+				return (m_nRead > 0);
+			}
+
+			void FlushWriteBuffer()
+			{
+				if (m_nWrite == 0) return;
+				UInt32 nWrite = m_nWrite;
+				m_nWrite = 0;
+				m_pBase->Write(m_Buffer.At(), nWrite);
+				if (m_BasePosition != Int64_MaxValue) m_BasePosition += nWrite;
+			}
+
+			/// <summary>Discards any unconsumed read-ahead, returning the base stream to the position the caller expects.</summary>
+			void DiscardReadBuffer()
+			{
+				if (m_iRead < m_nRead)
+				{
+					if (!m_pBase->CanSeek()) throw NotSupportedException(S("Cannot write to a BufferedStream with unread buffered data when the underlying stream is not seekable."));
+					m_pBase->Seek(-(Int64)(m_nRead - m_iRead), SeekOrigin::Current);
+					if (m_BasePosition != Int64_MaxValue) m_BasePosition -= (m_nRead - m_iRead);
+				}
+				m_iRead = m_nRead = 0;
+			}
+
+		public:
+
+			/// <summary>The buffer size used when none is specified.</summary>
+			static const UInt32 DefaultBufferSize = 262144;			// 256KB
+
+			BufferedStream(memory::r_ptr<Stream>&& Base, UInt32 BufferSize = DefaultBufferSize)
+				: m_pBase(std::move(Base)), m_Buffer(BufferSize > 0 ? BufferSize : 1)
+			{
+				m_iRead = m_nRead = m_nWrite = 0;
+				m_BasePosition = Int64_MaxValue;
+			}
+
+			BufferedStream(const BufferedStream& /*cp*/) { throw Exception("Cannot copy a BufferedStream object."); }
+			BufferedStream& operator=(const BufferedStream& /*cp*/) { throw Exception("Cannot copy a BufferedStream object."); }
+
+			~BufferedStream() 
+			{ 
+				// The base stream is not closed here, as it may be owned elsewhere, but any pending writes must reach it.  Errors
+				// cannot be reported from a destructor; call Flush() or Close() first to observe them.
+				if (m_pBase.IsAssigned())
+				{
+					try { FlushWriteBuffer(); } catch (...) { }
+				}
+			}
+
+			UInt32 GetBufferSize() const { return (UInt32)m_Buffer.GetSize(); }
+
+			bool CanRead() override { return m_pBase->CanRead(); }
+			bool CanWrite() override { return m_pBase->CanWrite(); }
+			bool CanSeek() override { return m_pBase->CanSeek(); }
+
+			/// <summary>Reads one byte from the stream and advances to the next byte position, or returns -1 if at the end of stream.</summary>
+			int ReadByte() override
+			{
+				if (m_iRead < m_nRead) return ((byte*)m_Buffer.At())[m_iRead++];
+				FlushWriteBuffer();
+				if (!FillReadBuffer()) return -1;
+				return ((byte*)m_Buffer.At())[m_iRead++];
+			}
+
+			Int64 Read(void* pBuffer, Int64 nLength) override
+			{
+				FlushWriteBuffer();
+				byte* pDst = (byte*)pBuffer;
+				Int64 count = 0;
+				while (count < nLength)
+				{
+					if (m_iRead < m_nRead)
+					{
+						Int64 nCopy = (Int64)(m_nRead - m_iRead);
+						if (nCopy > nLength - count) nCopy = nLength - count;
+						CopyMemory(pDst + count, ((byte*)m_Buffer.At()) + m_iRead, nCopy);
+						m_iRead += (UInt32)nCopy;
+						count += nCopy;
+						continue;
+					}
+
+					// Large requests bypass the buffer to avoid an extra copy.
+					if (nLength - count >= (Int64)m_Buffer.GetSize())
+					{
+						m_iRead = m_nRead = 0;
+						Int64 nRead = m_pBase->Read(pDst + count, nLength - count);
+						if (nRead <= 0) return count;
+						if (m_BasePosition != Int64_MaxValue) m_BasePosition += nRead;
+						count += nRead;
+						continue;
+					}
+
+					if (!FillReadBuffer()) return count;
+				}
+				return count;
+			}
+
+			const byte* GetReadWindow(Int64& nAvailable) override
+			{
+				if (m_iRead == m_nRead) { FlushWriteBuffer(); FillReadBuffer(); }
+				nAvailable = (Int64)(m_nRead - m_iRead);
+				return ((const byte*)m_Buffer.At()) + m_iRead;
+			}
+			void AdvanceReadWindow(Int64 nBytes) override { m_iRead += (UInt32)nBytes; }
+
+			void AdviseAccess(AccessPattern Pattern) override { m_pBase->AdviseAccess(Pattern); }
+			void AdviseWillNeed(Int64 Offset, Int64 nLength) override { m_pBase->AdviseWillNeed(Offset, nLength); }
+			void AdviseDontNeed(Int64 Offset, Int64 nLength) override { m_pBase->AdviseDontNeed(Offset, nLength); }
+
+			void WriteByte(byte ch) override
+			{
+				if (m_nRead > 0) DiscardReadBuffer();
+				if (m_nWrite >= m_Buffer.GetSize()) FlushWriteBuffer();
+				((byte*)m_Buffer.At())[m_nWrite++] = ch;
+			}
+
+			void Write(const void *pBuffer, Int64 nLength) override
+			{
+				if (m_nRead > 0) DiscardReadBuffer();
+				if ((Int64)m_nWrite + nLength <= (Int64)m_Buffer.GetSize())
+				{
+					CopyMemory(((byte*)m_Buffer.At()) + m_nWrite, pBuffer, nLength);
+					m_nWrite += (UInt32)nLength;
+					return;
+				}
+
+				FlushWriteBuffer();
+
+				// Large writes bypass the buffer to avoid an extra copy.
+				if (nLength >= (Int64)m_Buffer.GetSize())
+				{
+					m_pBase->Write(pBuffer, nLength);
+					if (m_BasePosition != Int64_MaxValue) m_BasePosition += nLength;
+					return;
+				}
+
+				CopyMemory(m_Buffer.At(), pBuffer, nLength);
+				m_nWrite = (UInt32)nLength;
+			}
+
+			void WriteGather(const void *pHead, Int64 nHead, const void *pBody, Int64 nBody) override
+			{
+				if (m_nRead > 0) DiscardReadBuffer();
+				if ((Int64)m_nWrite + nHead + nBody <= (Int64)m_Buffer.GetSize())
+				{
+					CopyMemory(((byte*)m_Buffer.At()) + m_nWrite, pHead, nHead);
+					CopyMemory(((byte*)m_Buffer.At()) + m_nWrite + nHead, pBody, nBody);
+					m_nWrite += (UInt32)(nHead + nBody);
+					return;
+				}
+
+				// The body goes straight from the caller's memory to the underlying stream, gathered with the buffered data and the 
+				// head so that the underlying stream can submit them together.
+				if ((Int64)m_nWrite + nHead > (Int64)m_Buffer.GetSize())
+				{
+					FlushWriteBuffer();
+					if (nHead >= (Int64)m_Buffer.GetSize())
+					{
+						m_pBase->WriteGather(pHead, nHead, pBody, nBody);
+						if (m_BasePosition != Int64_MaxValue) m_BasePosition += nHead + nBody;
+						return;
+					}
+				}
+				CopyMemory(((byte*)m_Buffer.At()) + m_nWrite, pHead, nHead);
+				UInt32 nBuffered = m_nWrite + (UInt32)nHead;
+				m_nWrite = 0;
+				m_pBase->WriteGather(m_Buffer.At(), nBuffered, pBody, nBody);
+				if (m_BasePosition != Int64_MaxValue) m_BasePosition += nBuffered + nBody;
+			}
+
+			void WriteGather(const GatherEntry* pEntries, int nEntries) override
+			{
+				Int64 nTotal = 0;
+				for (int ii = 0; ii < nEntries; ii++) nTotal += pEntries[ii].nLength;
+				if (nTotal < (Int64)m_Buffer.GetSize()) { Stream::WriteGather(pEntries, nEntries); return; }
+
+				// Large lists go straight from the caller's memory to the underlying stream, after any buffered data.
+				if (m_nRead > 0) DiscardReadBuffer();
+				FlushWriteBuffer();
+				m_pBase->WriteGather(pEntries, nEntries);
+				if (m_BasePosition != Int64_MaxValue) m_BasePosition += nTotal;
+			}
+
+			Int64 GetPosition() const override
+			{
+				if (m_BasePosition == Int64_MaxValue) m_BasePosition = m_pBase->GetPosition();
+				return m_BasePosition + (Int64)m_nWrite - (Int64)(m_nRead - m_iRead);
+			}
+
+			Int64 GetLength() const override 
+			{ 
+				Int64 Length = m_pBase->GetLength();
+				if (m_nWrite > 0 && GetPosition() > Length) return GetPosition();
+				return Length;
+			}
+
+			void Seek(Int64 offset, SeekOrigin origin) override
+			{
+				FlushWriteBuffer();
+
+				Int64 Target;
+				switch (origin)
+				{
+				case SeekOrigin::Begin: Target = offset; break;
+				case SeekOrigin::Current: Target = GetPosition() + offset; break;
+				case SeekOrigin::End:
+					m_iRead = m_nRead = 0;
+					m_pBase->Seek(offset, SeekOrigin::End);
+					m_BasePosition = Int64_MaxValue;
+					return;
+				default: throw ArgumentException(S("Invalid origin."));
+				}
+
+				// If the target lies within the buffered region, no base stream operation is needed.
+				Int64 BufferStart = GetPosition() - (Int64)m_iRead;
+				if (Target >= BufferStart && Target <= BufferStart + (Int64)m_nRead)
+				{
+					m_iRead = (UInt32)(Target - BufferStart);
+					return;
+				}
+
+				m_iRead = m_nRead = 0;
+				m_pBase->Seek(Target, SeekOrigin::Begin);
+				m_BasePosition = Target;
+			}
+
+			/// <summary>Passes any buffered writes to the underlying stream and then flushes the underlying stream.</summary>
+			void Flush() override 
+			{ 
+				FlushWriteBuffer();
+				m_pBase->Flush(); 
+			}
+
+			void Close() override
+			{
+				m_iRead = m_nRead = 0;
+				if (m_pBase.IsAssigned()) 
+				{
+					FlushWriteBuffer();
+					m_pBase->Close();
+				}
+			}
+		};
+	}
+}
+
+#endif	// __WBBufferedStream_h__
+
+//	End of BufferedStream.h
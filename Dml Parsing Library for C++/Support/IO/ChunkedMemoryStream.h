@@ -0,0 +1,238 @@
+/*	ChunkedMemoryStream.h
+	Copyright (C) 2014 by Wiley Black (TheWiley@gmail.com)
+*/
+
+#ifndef __WBChunkedMemoryStream_h__
+#define __WBChunkedMemoryStream_h__
+
+#include "Streams.h"
+#include "../Memory Management/Buffer.h"
+
+namespace wb
+{
+	namespace io
+	{
+		/// <summary>ChunkedMemoryStream implements the Stream abstract class using a list of fixed-size chunks of memory as the
+		/// stream's backing store.  Unlike MemoryStream, the stream's content is never moved as it grows: appending allocates a new
+		/// chunk when the last one fills, so that building a very large document in memory takes time proportional to its size and
+		/// needs little more memory than its final size.  Reading, writing, and seeking are supported anywhere in the stream, but the
+		/// content is not contiguous, so direct reads are not available.  Use GetChunkCount() and GetChunk() to access the content
+		/// in place, or WriteTo() to pass it to another stream without an intermediate copy.</summary>
+		class ChunkedMemoryStream : public Stream
+		{
+			wb::memory::Buffer	m_Table;			// Array of pointers to the allocated chunks.
+			UInt64	m_nChunks;						// Number of allocated chunks.
+			UInt32	m_ChunkSize;
+			UInt64	m_iPosition;
+			UInt64	m_nLength;
+
+			byte**	GetTable() { return (byte**)m_Table.At(); }
+			byte* const* GetTable() const { return (byte* const*)m_Table.At(); }
+
+			/// <summary>Allocates chunks until at least nBytes of storage are available.</summary>
+			void AllocateTo(UInt64 nBytes)
+			{
+				UInt64 nRequired = (nBytes + m_ChunkSize - 1) / m_ChunkSize;
+				if (nRequired <= m_nChunks) return;
+				if (nRequired * sizeof(byte*) > m_Table.GetSize())
+				{
+					UInt64 nTable = m_Table.GetSize() / sizeof(byte*);
+					if (nTable < 16) nTable = 16;
+					while (nTable < nRequired) nTable *= 2;
+					m_Table.Realloc(nTable * sizeof(byte*));
+				}
+				while (m_nChunks < nRequired)
+				{
+					GetTable()[m_nChunks] = new byte [m_ChunkSize];
+					m_nChunks++;
+				}
+			}
+
+			void FreeChunks()
+			{
+				for (UInt64 ii = 0; ii < m_nChunks; ii++) delete[] GetTable()[ii];
+				m_nChunks = 0;
+			}
+
+		public:
+
+			/// <summary>The chunk size used when none is specified.</summary>
+			static const UInt32 DefaultChunkSize = 1048576;		// 1MB
+
+			ChunkedMemoryStream(UInt32 ChunkSize = DefaultChunkSize)
+			{
+				m_nChunks = 0;
+				m_ChunkSize = (ChunkSize > 0) ? ChunkSize : 1;
+				m_iPosition = 0;
+				m_nLength = 0;
+			}
+
+			ChunkedMemoryStream(const ChunkedMemoryStream& /*cp*/) { throw Exception("Cannot copy a ChunkedMemoryStream object."); }
+			ChunkedMemoryStream& operator=(const ChunkedMemoryStream& /*cp*/) { throw Exception("Cannot copy a ChunkedMemoryStream object."); }
+
+			ChunkedMemoryStream(ChunkedMemoryStream&& mv) : m_Table(std::move(mv.m_Table))
+			{
+				m_nChunks = mv.m_nChunks;
+				m_ChunkSize = mv.m_ChunkSize;
+				m_iPosition = mv.m_iPosition;
+				m_nLength = mv.m_nLength;
+				mv.m_nChunks = 0;
+				mv.m_iPosition = mv.m_nLength = 0;
+			}
+
+			ChunkedMemoryStream& operator=(ChunkedMemoryStream&& mv)
+			{
+				FreeChunks();
+				m_Table = std::move(mv.m_Table);
+				m_nChunks = mv.m_nChunks;
+				m_ChunkSize = mv.m_ChunkSize;
+				m_iPosition = mv.m_iPosition;
+				m_nLength = mv.m_nLength;
+				mv.m_nChunks = 0;
+				mv.m_iPosition = mv.m_nLength = 0;
+				return *this;
+			}
+
+			~ChunkedMemoryStream() { FreeChunks(); }
+
+			bool CanRead() override { return true; }
+			bool CanWrite() override { return true; }
+			bool CanSeek() override { return true; }
+
+			/// <summary>Reads one byte from the stream and advances to the next byte position, or returns -1 if at the end of stream.</summary>
+			int ReadByte() override
+			{
+				if (m_iPosition >= m_nLength) return -1;
+				int ret = GetTable()[m_iPosition / m_ChunkSize][m_iPosition % m_ChunkSize];
+				m_iPosition++;
+				return ret;
+			}
+
+			Int64 Read(void* pBuffer, Int64 nLength) override
+			{
+				if (m_iPosition >= m_nLength) return 0;
+				if ((UInt64)nLength > m_nLength - m_iPosition) nLength = (Int64)(m_nLength - m_iPosition);
+				byte* pDst = (byte*)pBuffer;
+				Int64 count = 0;
+				while (count < nLength)
+				{
+					UInt32 iOffset = (UInt32)(m_iPosition % m_ChunkSize);
+					Int64 nCopy = m_ChunkSize - iOffset;
+					if (nCopy > nLength - count) nCopy = nLength - count;
+					CopyMemory(pDst + count, GetTable()[m_iPosition / m_ChunkSize] + iOffset, (size_t)nCopy);
+					m_iPosition += nCopy;
+					count += nCopy;
+				}
+				return count;
+			}
+
+			void WriteByte(byte ch) override
+			{
+				if (m_iPosition >= m_nChunks * m_ChunkSize) AllocateTo(m_iPosition + 1);
+				GetTable()[m_iPosition / m_ChunkSize][m_iPosition % m_ChunkSize] = ch;
+				m_iPosition++;
+				if (m_iPosition > m_nLength) m_nLength = m_iPosition;
+			}
+
+			void Write(const void *pBuffer, Int64 nLength) override
+			{
+				if (nLength <= 0) return;
+				AllocateTo(m_iPosition + nLength);
+				const byte* pSrc = (const byte*)pBuffer;
+				while (nLength > 0)
+				{
+					UInt32 iOffset = (UInt32)(m_iPosition % m_ChunkSize);
+					Int64 nCopy = m_ChunkSize - iOffset;
+					if (nCopy > nLength) nCopy = nLength;
+					CopyMemory(GetTable()[m_iPosition / m_ChunkSize] + iOffset, pSrc, (size_t)nCopy);
+					m_iPosition += nCopy;
+					pSrc += nCopy;
+					nLength -= nCopy;
+				}
+				if (m_iPosition > m_nLength) m_nLength = m_iPosition;
+			}
+
+			/// <summary>The read window extends to the end of the chunk containing the current position.</summary>
+			const byte* GetReadWindow(Int64& nAvailable) override
+			{
+				if (m_iPosition >= m_nLength) { nAvailable = 0; return nullptr; }
+				UInt32 iOffset = (UInt32)(m_iPosition % m_ChunkSize);
+				nAvailable = m_ChunkSize - iOffset;
+				if ((UInt64)nAvailable > m_nLength - m_iPosition) nAvailable = (Int64)(m_nLength - m_iPosition);
+				return GetTable()[m_iPosition / m_ChunkSize] + iOffset;
+			}
+			void AdvanceReadWindow(Int64 nBytes) override { m_iPosition += nBytes; }
+
+			Int64 GetPosition() const override { return m_iPosition; }
+			Int64 GetCapacity() const { return m_nChunks * m_ChunkSize; }
+			Int64 GetLength() const override { return m_nLength; }
+			UInt32 GetChunkSize() const { return m_ChunkSize; }
+
+			void Seek(Int64 offset, SeekOrigin origin) override
+			{
+				Int64 Target;
+				switch (origin)
+				{
+				case SeekOrigin::Begin: Target = offset; break;
+				case SeekOrigin::Current: Target = (Int64)m_iPosition + offset; break;
+				case SeekOrigin::End: Target = (Int64)m_nLength + offset; break;
+				default: throw ArgumentException(S("Invalid origin."));
+				}
+				if (Target < 0) throw IOException(S("Attempted to seek before the beginning of the stream."));
+				m_iPosition = (UInt64)Target;
+			}
+
+			void Close() override { }
+
+			void Rewind() { m_iPosition = 0; }
+
+			/// <summary>Reserve() allocates storage for a stream of at least nBytes in advance, as a hint when the final size is
+			/// approximately known.  The length of the stream is not changed.</summary>
+			void Reserve(Int64 nBytes) { if (nBytes > 0) AllocateTo(nBytes); }
+
+			/// <summary>Sets the length of the stream, allocating storage if it grows.  Storage is retained if it shrinks.</summary>
+			void SetLength(Int64 nBytes) { AllocateTo(nBytes); m_nLength = nBytes; }
+
+			/// <summary>Releases all storage and empties the stream.</summary>
+			void Clear() { FreeChunks(); m_Table.Free(); m_iPosition = m_nLength = 0; }
+
+			/** Gather Access **/
+
+			/// <summary>GetChunkCount() returns the number of chunks that hold the stream's content, from position zero to its
+			/// length.</summary>
+			UInt64 GetChunkCount() const { return (m_nLength + m_ChunkSize - 1) / m_ChunkSize; }
+
+			/// <summary>GetChunk() provides the content of one chunk in place.  All chunks except the last hold GetChunkSize()
+			/// bytes.</summary>
+			/// <param name="nBytes">Receives the number of bytes of content in the chunk.</param>
+			const byte* GetChunk(UInt64 Index, Int64& nBytes) const
+			{
+				if (Index >= GetChunkCount()) throw ArgumentOutOfRangeException(S("Chunk index out of range."));
+				UInt64 Start = Index * m_ChunkSize;
+				nBytes = (m_nLength - Start < m_ChunkSize) ? (Int64)(m_nLength - Start) : (Int64)m_ChunkSize;
+				return GetTable()[Index];
+			}
+
+			/// <summary>WriteTo() writes the entire content of the stream to Destination, directly from the chunks.  Chunks are
+			/// passed through Stream::WriteGather() in batches of MaxGatherEntries, so that a FileStream can submit each batch in a
+			/// single system call.  The position of this stream is not changed.</summary>
+			void WriteTo(Stream& Destination) const
+			{
+				GatherEntry Entries[MaxGatherEntries];
+				UInt64 nChunks = GetChunkCount();
+				UInt64 ii = 0;
+				while (ii < nChunks)
+				{
+					int nEntries = 0;
+					for (; ii < nChunks && nEntries < MaxGatherEntries; ii++, nEntries++)
+						Entries[nEntries].pData = GetChunk(ii, Entries[nEntries].nLength);
+					Destination.WriteGather(Entries, nEntries);
+				}
+			}
+		};
+	}
+}
+
+#endif	// __WBChunkedMemoryStream_h__
+
+//	End of ChunkedMemoryStream.h
@@ -6,8 +6,12 @@
 #define __EndianBinaryReader_h__
 
 #include "../Platforms/Platforms.h"
+#include "../Platforms/EndianSwap.h"
 #include "Streams.h"
 #include "../Memory Management/Allocation.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace wb
 {
@@ -17,6 +21,11 @@ namespace wb
 		{			
 			bool IsPlatformLittleEndian;
 
+			// Logical position of the next byte to be read, or Int64_MaxValue if not yet known or lost after an error.
+			Int64 m_Position;
+
+			void Advance(Int64 nBytes) { if (m_Position != Int64_MaxValue) m_Position += nBytes; }
+
 			static bool TestPlatformLittleEndian()
 			{
 				union {
@@ -24,7 +33,7 @@ namespace wb
 					char c[4];
 				} bint = {0x01020304};
 
-				return (bint.c[0] == 1);
+				return (bint.c[0] == 4);
 			}
 
 			void ReversedRead(byte *pBuffer, Int64 nLength)
@@ -33,8 +42,9 @@ namespace wb
 				while (nLength > 0) { 
 					nLength--; 
 					ch = m_pStream->ReadByte();
-					if (ch < 0) throw EndOfStreamException();
+					if (ch < 0) { m_Position = Int64_MaxValue; throw EndOfStreamException(); }
 					pBuffer[nLength] = ch;
+					Advance(1);
 				}
 			}
 
@@ -44,6 +54,78 @@ namespace wb
 				else ReversedRead(pBuffer, nLength);
 			}
 
+			/** Compact-Integer decoding from the stream's read window **/
+
+			/// <summary>Counts the leading zero bits in a non-zero byte.</summary>
+			static int LeadingZeros(byte ch)
+			{
+				#if defined(_MSC_VER)
+				unsigned long iBit;
+				_BitScanReverse(&iBit, ch);
+				return 7 - (int)iBit;
+				#else
+				return __builtin_clz((unsigned int)ch) - (int)(8 * sizeof(unsigned int) - 8);
+				#endif
+			}
+
+			void AdvanceWindow(Int64 nBytes) { m_pStream->AdvanceReadWindow(nBytes); Advance(nBytes); }
+
+			UInt64 LoadBigEndian64(const byte* p) const
+			{
+				UInt64 ret;
+				CopyMemory(&ret, p, sizeof(ret));
+				return IsPlatformLittleEndian ? SwapEndian(ret) : ret;
+			}
+
+			/// <summary>WindowCompact64() decodes a Compact-64 value directly from the stream's read window with a single load when 
+			/// the window holds enough bytes for any encoding.  Returns the number of value bits in the encoding, or zero if the 
+			/// window could not be used and the caller should decode byte-by-byte.</summary>
+			int WindowCompact64(UInt64& Value)
+			{
+				Int64 nAvailable;
+				const byte* p = m_pStream->GetReadWindow(nAvailable);
+				if (nAvailable < 9) return 0;
+
+				byte ch = p[0];
+				if ((ch & 0x80) == 0x80) { Value = ch & 0x7F; AdvanceWindow(1); return 7; }
+				if (ch == 0) { Value = LoadBigEndian64(p + 1); AdvanceWindow(9); return 64; }
+
+				// The count of leading zeros in the first byte gives the number of bytes that follow it, and each byte of the 
+				// encoding carries 7 bits of value.
+				int nLength = LeadingZeros(ch) + 1;
+				int nBits = 7 * nLength;
+				Value = (LoadBigEndian64(p) >> (64 - 8 * nLength)) & ((1ull << nBits) - 1);
+				AdvanceWindow(nLength);
+				return nBits;
+			}
+
+			/// <summary>WindowCompact32() is the Compact-32 counterpart of WindowCompact64().  Returns false if the window could not be
+			/// used, including for invalid encodings, which are left to the byte-by-byte decoder to report.</summary>
+			bool WindowCompact32(UInt32& Value)
+			{
+				Int64 nAvailable;
+				const byte* p = m_pStream->GetReadWindow(nAvailable);
+				if (nAvailable < 8) return false;
+
+				byte ch = p[0];
+				if ((ch & 0x80) == 0x80) { Value = ch & 0x7F; AdvanceWindow(1); return true; }
+				if (ch >= 0x10)
+				{
+					int nLength = LeadingZeros(ch) + 1;
+					int nBits = 7 * nLength;
+					Value = (UInt32)((LoadBigEndian64(p) >> (64 - 8 * nLength)) & ((1ull << nBits) - 1));
+					AdvanceWindow(nLength);
+					return true;
+				}
+				if (ch == 0x08)
+				{
+					Value = (UInt32)((LoadBigEndian64(p) >> 24) & 0xFFFFFFFFull);
+					AdvanceWindow(5);
+					return true;
+				}
+				return false;
+			}
+
 		public:
 
 			memory::r_ptr<Stream> m_pStream;
@@ -53,6 +135,7 @@ namespace wb
 			BinaryReader(memory::r_ptr<Stream>&& Stream, bool LittleEndianStream)
 				:	
 				IsPlatformLittleEndian(TestPlatformLittleEndian()),
+				m_Position(Int64_MaxValue),
 				m_pStream(std::move(Stream)),
 				IsLittleEndian(LittleEndianStream)
 			{
@@ -82,32 +165,121 @@ namespace wb
 			/// <summary>IsLittleEndian indicates that the stream is operating in little (true) or big (false) endian. </summary>
 			bool IsLittleEndian;
 
+			/// <summary>IsNativeOrder() indicates that the stream's byte order, as given by IsLittleEndian, matches the platform's 
+			/// so that multi-byte values can be used from the stream without swapping.</summary>
+			bool IsNativeOrder() const { return IsLittleEndian == IsPlatformLittleEndian; }
+
+			/// <summary>SizeCompact64() gives the length, in bytes, of a Compact-64 encoding from its first byte.</summary>
+			static int SizeCompact64(byte FirstByte) { return (FirstByte == 0) ? 9 : LeadingZeros(FirstByte) + 1; }
+
 			/*** Elementary readers ***/
 
 			byte ReadByte() 
 			{ 
 				int ch = m_pStream->ReadByte();  
-				if (ch < 0) throw EndOfStreamException();
+				if (ch < 0) { m_Position = Int64_MaxValue; throw EndOfStreamException(); }
+				Advance(1);
 				return (byte)ch;
 			}
 
 			void Read(byte *pBuffer, Int64 nLength) 
 			{ 
 				Int64 nRead = m_pStream->Read(pBuffer, nLength); 
-				if (nRead == nLength) return;
+				if (nRead == nLength) { Advance(nLength); return; }
+				m_Position = Int64_MaxValue;
 				if (nRead < 0) throw IOException();
 				throw EndOfStreamException();
 			}
 
 			void Read(char *pBuffer, Int64 nLength) { Read((byte *)pBuffer, nLength); }
 
+			/// <summary>ReadDirect() returns a pointer to the next nLength bytes within the stream's own storage, without copying,
+			/// and advances past them.  The stream must support direct reads (see Stream::CanReadDirect()).</summary>
+			const byte* ReadDirect(Int64 nLength)
+			{
+				const byte* pData = m_pStream->ReadDirect(nLength);
+				if (pData != nullptr) { Advance(nLength); return pData; }
+				if (!m_pStream->CanReadDirect()) throw NotSupportedException(S("Stream does not support direct reads."));
+				throw EndOfStreamException();
+			}
+
+			/*** Position tracking ***/
+
+			/// <summary>GetPosition() returns the stream position of the next byte to be read.  The BinaryReader counts the bytes that
+			/// it reads, skips and seeks over, so the underlying stream is only queried on the first call or after an error.  If the
+			/// stream is repositioned other than through this BinaryReader after GetPosition() has been called, InvalidatePosition()
+			/// must be called.</summary>
+			Int64 GetPosition()
+			{
+				if (m_Position == Int64_MaxValue) m_Position = m_pStream->GetPosition();
+				return m_Position;
+			}
+
+			/// <summary>InvalidatePosition() discards the tracked position so that the next GetPosition() call queries the stream.</summary>
+			void InvalidatePosition() { m_Position = Int64_MaxValue; }
+
+			/// <summary>Seek() repositions the underlying stream and keeps the tracked position up to date.</summary>
+			void Seek(Int64 offset, SeekOrigin origin)
+			{
+				Int64 Target = Int64_MaxValue;
+				if (origin == SeekOrigin::Begin) Target = offset;
+				else if (origin == SeekOrigin::Current && m_Position != Int64_MaxValue) Target = m_Position + offset;
+				m_Position = Int64_MaxValue;
+				m_pStream->Seek(offset, origin);
+				m_Position = Target;
+			}
+
+			/// <summary>Skip() advances past nBytes without returning them.  A seekable stream is repositioned.  Otherwise, bytes
+			/// already in the stream's read window are consumed in place and any others are read into pScratch, which holds nScratch
+			/// bytes.</summary>
+			void Skip(UInt64 nBytes, byte* pScratch, Int64 nScratch)
+			{
+				if (m_pStream->CanSeek()) { Seek((Int64)nBytes, SeekOrigin::Current); return; }
+				while (nBytes > 0)
+				{
+					Int64 nAvailable;
+					m_pStream->GetReadWindow(nAvailable);
+					if (nAvailable > 0)
+					{
+						Int64 nSkip = (nBytes < (UInt64)nAvailable) ? (Int64)nBytes : nAvailable;
+						AdvanceWindow(nSkip);
+						nBytes -= (UInt64)nSkip;
+						continue;
+					}
+					Int64 nRead = (nBytes < (UInt64)nScratch) ? (Int64)nBytes : nScratch;
+					Read(pScratch, nRead);
+					nBytes -= (UInt64)nRead;
+				}
+			}
+
 			/** Compact-Integer readers (Endian-Independent) **/
 
 			UInt32 ReadCompact32()
 			{
 				UInt32 ret = 0;
-				byte ch = ReadByte();
+				if (WindowCompact32(ret)) return ret;
+				return ReadCompact32(ReadByte());
+			}
+
+			/// <summary>TryReadCompact32() reads a Compact-32 value in the same manner as ReadCompact32(), but returns false
+			/// instead of throwing if the stream is already at its end.  An encoding cut short by the end of the stream still
+			/// throws an EndOfStreamException.</summary>
+			bool TryReadCompact32(UInt32& Value)
+			{
+				if (WindowCompact32(Value)) return true;
+				int ch = m_pStream->ReadByte();
+				if (ch < 0) { m_Position = Int64_MaxValue; return false; }
+				Advance(1);
+				Value = ReadCompact32((byte)ch);
+				return true;
+			}
+
+		private:
 
+			/// <summary>Completes a Compact-32 value given its first byte.</summary>
+			UInt32 ReadCompact32(byte ch)
+			{
+				UInt32 ret = 0;
 				if ((ch & 0x80) == 0x80)
 					ret = ((UInt32)ch & 0x7F);
 				else if ((ch & 0xC0) == 0x40)
@@ -138,16 +310,20 @@ namespace wb
 				else
 				{
 					if (m_pStream->CanSeek())
-						throw Exception("Invalid Compact-32 encoding sequence at position [" + to_string(m_pStream->GetPosition()) + "].");
+						throw Exception("Invalid Compact-32 encoding sequence at position [" + to_string(GetPosition()) + "].");
 					else
 						throw FormatException("Invalid Compact-32 encoding sequence.");
 				}
 				return ret;
 			}
 
+		public:
+
 			UInt64 ReadCompact64()
 			{
 				UInt64 ret = 0;
+				if (WindowCompact64(ret) != 0) return ret;
+
 				byte ch = ReadByte();
 
 				if ((ch & 0x80) == 0x80) ret = ((UInt64)ch & 0x7F);
@@ -225,6 +401,10 @@ namespace wb
 			Int64 ReadCompactS64()
 			{
 				UInt64 ret = 0;
+				int nBits = WindowCompact64(ret);
+				if (nBits == 64) return (Int64)ret;
+				if (nBits != 0) return SignExtend(ret, nBits);
+
 				byte ch = ReadByte();
 
 				if ((ch & 0x80) == 0x80) return SignExtend(((UInt64)ch & 0x7F), 7);
@@ -308,7 +488,7 @@ namespace wb
 			Int64 SignExtend(UInt64 Value, int nBits)
 			{
 				// See ReadI() for similar explanation...            
-				UInt64 mask = (1UL << (nBits - 1));
+				UInt64 mask = ((UInt64)1 << (nBits - 1));
 				if ((Value & mask) != 0UL)
 				{
 					UInt64 extendmask = UInt64_MaxValue << nBits;
@@ -385,22 +565,19 @@ namespace wb
 			void Read(UInt16* pBuffer, Int64 Elements)
 			{
 				Read((byte *)pBuffer, Elements * sizeof(pBuffer[0]));
-				if (IsLittleEndian != IsPlatformLittleEndian)
-					for (int ii=0; ii < Elements; ii++) pBuffer[ii] = SwapEndian(pBuffer[ii]);
+				if (IsLittleEndian != IsPlatformLittleEndian) SwapEndianCopy(pBuffer, pBuffer, (size_t)Elements, sizeof(pBuffer[0]));
 			}
 
 			void Read(UInt32* pBuffer, Int64 Elements)
 			{
 				Read((byte *)pBuffer, Elements * sizeof(pBuffer[0]));
-				if (IsLittleEndian != IsPlatformLittleEndian)
-					for (int ii=0; ii < Elements; ii++) pBuffer[ii] = SwapEndian(pBuffer[ii]);
+				if (IsLittleEndian != IsPlatformLittleEndian) SwapEndianCopy(pBuffer, pBuffer, (size_t)Elements, sizeof(pBuffer[0]));
 			}
 
 			void Read(UInt64* pBuffer, Int64 Elements)
 			{
 				Read((byte *)pBuffer, Elements * sizeof(pBuffer[0]));
-				if (IsLittleEndian != IsPlatformLittleEndian)
-					for (int ii=0; ii < Elements; ii++) pBuffer[ii] = SwapEndian(pBuffer[ii]);
+				if (IsLittleEndian != IsPlatformLittleEndian) SwapEndianCopy(pBuffer, pBuffer, (size_t)Elements, sizeof(pBuffer[0]));
 			}
 
 			void Read(Int16* pBuffer, Int64 Elements) { return Read((UInt16*)pBuffer, Elements); }
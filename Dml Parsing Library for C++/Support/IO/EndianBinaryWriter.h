@@ -6,6 +6,7 @@
 #define __EndianBinaryWriter_h__
 
 #include "../Platforms/Platforms.h"
+#include "../Platforms/EndianSwap.h"
 #include "Streams.h"
 #include "../Memory Management/Allocation.h"
 
@@ -24,7 +25,7 @@ namespace wb
 					char c[4];
 				} bint = {0x01020304};
 
-				return (bint.c[0] == 1);
+				return (bint.c[0] == 4);
 			}
 
 			void ReversedWrite(byte *pBuffer, int nLength)
@@ -38,6 +39,23 @@ namespace wb
 				else ReversedWrite(pBuffer, nLength);
 			}
 
+			/// <summary>Writes an array of elements in the opposite byte order from the platform.  The elements are converted in blocks
+			/// through a staging buffer so that the stream receives a few large writes instead of one call per byte.</summary>
+			void WriteSwapped(const void* pData, Int64 nElements, size_t ElementSize)
+			{
+				byte Staging[8192];
+				const Int64 BlockElements = (Int64)(sizeof(Staging) / ElementSize);
+				const byte* pSrc = (const byte*)pData;
+				while (nElements > 0)
+				{
+					Int64 nBlock = (nElements < BlockElements) ? nElements : BlockElements;
+					SwapEndianCopy(Staging, pSrc, (size_t)nBlock, ElementSize);
+					m_pStream->Write(Staging, nBlock * ElementSize);
+					pSrc += nBlock * ElementSize;
+					nElements -= nBlock;
+				}
+			}
+
 		public:
 
 			memory::r_ptr<Stream>	m_pStream;
@@ -93,6 +111,24 @@ namespace wb
 				else return 5;
 			}
 
+			/// <summary>EncodeCompact64() stores the Compact-64 encoding of Value at pDst, which must have room for 9 bytes, and returns
+			/// the number of bytes used.  The encoding is identical to that of WriteCompact64(), and also to WriteCompact32() for
+			/// values that fit in 32 bits.</summary>
+			static int EncodeCompact64(byte* pDst, UInt64 Value)
+			{
+				int nLength = SizeCompact64(Value);
+				if (nLength == 9)
+				{
+					pDst[0] = 0;
+					for (int ii = 8; ii >= 1; ii--) { pDst[ii] = (byte)Value; Value >>= 8; }
+					return 9;
+				}
+				// The leading byte carries a marker bit whose position gives the number of bytes that follow it.
+				Value |= (0x80ull >> (nLength - 1)) << (8 * (nLength - 1));
+				for (int ii = nLength - 1; ii >= 0; ii--) { pDst[ii] = (byte)Value; Value >>= 8; }
+				return nLength;
+			}
+
 			void WriteCompact32(UInt32 Value)
 			{
 				if (Value <= 0x7F)
@@ -431,16 +467,7 @@ namespace wb
 			void Write(const UInt16* pData, Int64 nElements)
 			{
 				if (IsLittleEndian == IsPlatformLittleEndian) Write((byte *)pData, nElements * sizeof(pData[0]));
-				else
-				{
-					byte *pRawData = (byte *)pData;					
-					byte ch1, ch2;
-					for (int ii=0; ii < nElements; ii++)
-					{
-						ch1 = *pRawData++; ch2 = *pRawData++;
-						Write(ch2); Write(ch1);
-					}
-				}
+				else WriteSwapped(pData, nElements, sizeof(pData[0]));
 			}
 
 			void Write(const Int16* pData, Int64 nElements) { Write((UInt16*)pData, nElements); }
@@ -448,16 +475,7 @@ namespace wb
 			void Write(const UInt32* pData, Int64 nElements)
 			{
 				if (IsLittleEndian == IsPlatformLittleEndian) Write((byte*)pData, nElements * sizeof(pData[0]));
-				else
-				{
-					byte *pRawData = (byte *)pData;					
-					byte ch1, ch2, ch3, ch4;
-					for (int ii=0; ii < nElements; ii++)
-					{
-						ch1 = *pRawData++; ch2 = *pRawData++; ch3 = *pRawData++; ch4 = *pRawData++;
-						Write(ch4); Write(ch3); Write(ch2); Write(ch1);
-					}
-				}
+				else WriteSwapped(pData, nElements, sizeof(pData[0]));
 			}
 
 			void Write(const Int32* pData, Int64 nElements) { Write((UInt32*)pData, nElements); }			
@@ -466,22 +484,26 @@ namespace wb
 			void Write(const UInt64* pData, Int64 nElements)
 			{
 				if (IsLittleEndian == IsPlatformLittleEndian) Write((byte*)pData, nElements * sizeof(pData[0]));
-				else
-				{
-					byte *pRawData = (byte *)pData;
-					byte ch1, ch2, ch3, ch4, ch5, ch6, ch7, ch8;
-					for (int ii=0; ii < nElements; ii++)
-					{
-						ch1 = *pRawData++; ch2 = *pRawData++; ch3 = *pRawData++; ch4 = *pRawData++;
-						ch5 = *pRawData++; ch6 = *pRawData++; ch7 = *pRawData++; ch8 = *pRawData++;
-						Write(ch8); Write(ch7); Write(ch6); Write(ch5);
-						Write(ch4); Write(ch3); Write(ch2); Write(ch1);
-					}
-				}
+				else WriteSwapped(pData, nElements, sizeof(pData[0]));
 			}
 
 			void Write(const Int64* pData, Int64 nElements) { Write((UInt64*)pData, nElements); }
 			void Write(const double* pData, Int64 nElements) { Write((UInt64*)pData, nElements); }
+
+			/**** Gather Writers ****/
+
+			/// <summary>Writes a block of nHead bytes followed by an array of nElements elements of ElementSize bytes each, converted to
+			/// the stream's byte order.  When no conversion is needed, both are passed to the stream in one WriteGather() call so that
+			/// the array is not copied on its way to the underlying device.</summary>
+			void WriteGather(const byte* pHead, Int64 nHead, const void* pData, Int64 nElements, size_t ElementSize)
+			{
+				if (ElementSize == 1 || IsLittleEndian == IsPlatformLittleEndian) m_pStream->WriteGather(pHead, nHead, pData, nElements * ElementSize);
+				else
+				{
+					Write(pHead, nHead);
+					WriteSwapped(pData, nElements, ElementSize);
+				}
+			}
 		};
 	}
 }
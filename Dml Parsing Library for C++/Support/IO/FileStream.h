@@ -6,6 +6,9 @@
 #define __WBFileStream_h__
 
 #include "Streams.h"
+#if !defined(_WINDOWS)
+#include <sys/uio.h>
+#endif
 
 namespace wb
 {
@@ -315,6 +318,77 @@ namespace wb
 				#endif
 			}
 
+			#if !defined(_WINDOWS)
+			/// <summary>Writes both blocks with a single writev() call, so that a payload passes directly from the caller's memory to
+			/// the kernel along with its header.</summary>
+			void WriteGather(const void *pHead, Int64 nHead, const void *pBody, Int64 nBody) override
+			{
+				if (nHead + nBody > Int32_MaxValue) { Stream::WriteGather(pHead, nHead, pBody, nBody); return; }
+				struct iovec Blocks[2];
+				Blocks[0].iov_base = (void*)pHead; Blocks[0].iov_len = (size_t)nHead;
+				Blocks[1].iov_base = (void*)pBody; Blocks[1].iov_len = (size_t)nBody;
+				Int64 nWritten = writev(m_Handle, Blocks, 2);
+				if (nWritten < 0) Exception::ThrowFromErrno(errno);
+				if (nWritten == nHead + nBody) return;
+
+				// Complete a partial write.
+				if (nWritten < nHead) { Write(((const byte*)pHead) + nWritten, nHead - nWritten); nWritten = nHead; }
+				Write(((const byte*)pBody) + (nWritten - nHead), nBody - (nWritten - nHead));
+			}
+
+			/// <summary>Writes the blocks with one writev() call for each MaxGatherEntries blocks, or fewer where needed to keep each 
+			/// call within Int32_MaxValue bytes.</summary>
+			void WriteGather(const GatherEntry* pEntries, int nEntries) override
+			{
+				struct iovec Blocks[MaxGatherEntries];
+				int ii = 0;
+				while (ii < nEntries)
+				{
+					int nBlocks = 0;
+					Int64 nTotal = 0;
+					while (ii + nBlocks < nEntries && nBlocks < MaxGatherEntries && nTotal + pEntries[ii + nBlocks].nLength <= Int32_MaxValue)
+					{
+						Blocks[nBlocks].iov_base = (void*)pEntries[ii + nBlocks].pData;
+						Blocks[nBlocks].iov_len = (size_t)pEntries[ii + nBlocks].nLength;
+						nTotal += pEntries[ii + nBlocks].nLength;
+						nBlocks++;
+					}
+					if (nBlocks == 0) { Write(pEntries[ii].pData, pEntries[ii].nLength); ii++; continue; }
+
+					Int64 nWritten = writev(m_Handle, Blocks, nBlocks);
+					if (nWritten < 0) Exception::ThrowFromErrno(errno);
+					if (nWritten < nTotal)
+					{
+						// Complete a partial write.
+						for (int jj = 0; jj < nBlocks; jj++)
+						{
+							Int64 nBlock = (Int64)Blocks[jj].iov_len;
+							if (nWritten >= nBlock) { nWritten -= nBlock; continue; }
+							Write(((const byte*)Blocks[jj].iov_base) + nWritten, nBlock - nWritten);
+							nWritten = 0;
+						}
+					}
+					ii += nBlocks;
+				}
+			}
+
+			/** Access hints are passed to posix_fadvise().  On Windows, access hints are given only when a file is opened. **/
+
+			void AdviseAccess(AccessPattern Pattern) override
+			{
+				int Advice;
+				switch (Pattern)
+				{
+				case AccessPattern::Sequential: Advice = POSIX_FADV_SEQUENTIAL; break;
+				case AccessPattern::Random: Advice = POSIX_FADV_RANDOM; break;
+				default: Advice = POSIX_FADV_NORMAL; break;
+				}
+				posix_fadvise64(m_Handle, 0, 0, Advice);
+			}
+			void AdviseWillNeed(Int64 Offset, Int64 nLength) override { posix_fadvise64(m_Handle, Offset, nLength, POSIX_FADV_WILLNEED); }
+			void AdviseDontNeed(Int64 Offset, Int64 nLength) override { posix_fadvise64(m_Handle, Offset, nLength, POSIX_FADV_DONTNEED); }
+			#endif
+
 			Int64 GetPosition() const override { 
 				#if defined(_WINDOWS)				
 				LARGE_INTEGER zero; zero.QuadPart = 0;
@@ -387,7 +461,10 @@ namespace wb
 					if (!::FlushFileBuffers(m_Handle)) Exception::ThrowFromWin32(::GetLastError());
 				}
 				#else
-				#error Needs implementation for linux here.
+				if (m_Handle != -1)
+				{
+					if (fsync(m_Handle) != 0) Exception::ThrowFromErrno(errno);
+				}
 				#endif
 			}
 
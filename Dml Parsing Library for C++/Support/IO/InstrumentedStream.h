@@ -0,0 +1,222 @@
+/*	InstrumentedStream.h
+	Copyright (C) 2014 by Wiley Black (TheWiley@gmail.com)
+*/
+
+#ifndef __WBInstrumentedStream_h__
+#define __WBInstrumentedStream_h__
+
+#include "Streams.h"
+#include "../Memory Management/Allocation.h"
+
+#if defined(UseSTL)
+#include <chrono>
+
+namespace wb
+{
+	namespace io
+	{
+		/// <summary>StreamStatistics is a snapshot of the activity recorded by an InstrumentedStream.</summary>
+		struct StreamStatistics
+		{
+			/// <summary>Bytes passed through reads (Read(), ReadByte(), ReadDirect(), and consumed read windows) and writes.</summary>
+			UInt64	BytesRead;
+			UInt64	BytesWritten;
+
+			/// <summary>Number of calls of each kind made on the stream.  WriteCalls includes WriteGather() calls and ReadCalls includes
+			/// ReadDirect() calls.</summary>
+			UInt64	ReadCalls;
+			UInt64	ReadByteCalls;
+			UInt64	ReadWindowCalls;
+			UInt64	WriteCalls;
+			UInt64	WriteByteCalls;
+			UInt64	Seeks;
+			UInt64	Flushes;
+
+			/// <summary>Total time spent in calls on the underlying stream, in nanoseconds, if timing is enabled.</summary>
+			Int64	BaseNanoseconds;
+
+			/// <summary>Histograms of Read() and Write() request sizes, if enabled.  Bucket 0 counts requests of zero bytes, and bucket
+			/// N counts requests of at least 2^(N-1) and less than 2^N bytes.  Single-byte calls are counted in bucket 1.</summary>
+			static const int HistogramBuckets = 64;
+			UInt64	ReadSizes[HistogramBuckets];
+			UInt64	WriteSizes[HistogramBuckets];
+
+			StreamStatistics() { Clear(); }
+
+			void Clear() { ZeroMemory(this, sizeof(StreamStatistics)); }
+
+			/// <summary>Returns the histogram bucket that counts a request of nBytes.</summary>
+			static int GetBucket(Int64 nBytes)
+			{
+				int Bucket = 0;
+				for (UInt64 Size = (UInt64)nBytes; Size != 0; Size >>= 1) Bucket++;
+				return (Bucket < HistogramBuckets) ? Bucket : HistogramBuckets - 1;
+			}
+		};
+
+		/// <summary>InstrumentedStream passes all calls through to another stream while counting bytes, calls, and seeks, and
+		/// optionally timing the underlying stream and recording a histogram of request sizes.  It is used to diagnose slow I/O, such
+		/// as too many small reads or excessive seeking, without a profiler.  Place it directly above the stream to be measured: for
+		/// example, between a BufferedStream and a FileStream to observe the requests that reach the file.  Counting costs a few
+		/// instructions per call; timing adds two clock reads per call.  InstrumentedStream is not thread-safe, in the same manner
+		/// as the streams it wraps.</summary>
+		class InstrumentedStream : public Stream
+		{
+			memory::r_ptr<Stream>	m_pBase;
+			mutable StreamStatistics	m_Stats;
+			bool	m_Timing;
+			bool	m_Histogram;
+
+			/// <summary>Adds the time from construction to destruction to the statistics, when timing is enabled.</summary>
+			class BaseTimer
+			{
+				const InstrumentedStream& m_Stream;
+				std::chrono::steady_clock::time_point m_Start;
+			public:
+				BaseTimer(const InstrumentedStream& Stream) : m_Stream(Stream)
+				{
+					if (m_Stream.m_Timing) m_Start = std::chrono::steady_clock::now();
+				}
+				~BaseTimer()
+				{
+					if (m_Stream.m_Timing)
+						m_Stream.m_Stats.BaseNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Start).count();
+				}
+			};
+
+		public:
+
+			/// <summary>Constructs an InstrumentedStream over Base.</summary>
+			/// <param name="Timing">True to measure the time spent in the underlying stream.</param>
+			/// <param name="Histogram">True to record histograms of Read() and Write() request sizes.</param>
+			InstrumentedStream(memory::r_ptr<Stream>&& Base, bool Timing = true, bool Histogram = false)
+				: m_pBase(std::move(Base)), m_Timing(Timing), m_Histogram(Histogram)
+			{
+			}
+
+			InstrumentedStream(const InstrumentedStream& /*cp*/) { throw Exception("Cannot copy an InstrumentedStream object."); }
+			InstrumentedStream& operator=(const InstrumentedStream& /*cp*/) { throw Exception("Cannot copy an InstrumentedStream object."); }
+
+			/** Statistics Access & Control **/
+
+			StreamStatistics GetStatistics() const { return m_Stats; }
+			void ResetStatistics() { m_Stats.Clear(); }
+
+			/** Implementation **/
+
+			bool CanRead() override { return m_pBase->CanRead(); }
+			bool CanWrite() override { return m_pBase->CanWrite(); }
+			bool CanSeek() override { return m_pBase->CanSeek(); }
+
+			int ReadByte() override
+			{
+				m_Stats.ReadByteCalls++;
+				if (m_Histogram) m_Stats.ReadSizes[1]++;
+				BaseTimer Timer(*this);
+				int ch = m_pBase->ReadByte();
+				if (ch >= 0) m_Stats.BytesRead++;
+				return ch;
+			}
+
+			Int64 Read(void* pBuffer, Int64 nLength) override
+			{
+				m_Stats.ReadCalls++;
+				if (m_Histogram) m_Stats.ReadSizes[StreamStatistics::GetBucket(nLength)]++;
+				BaseTimer Timer(*this);
+				Int64 nBytes = m_pBase->Read(pBuffer, nLength);
+				m_Stats.BytesRead += nBytes;
+				return nBytes;
+			}
+
+			void WriteByte(byte ch) override
+			{
+				m_Stats.WriteByteCalls++;
+				if (m_Histogram) m_Stats.WriteSizes[1]++;
+				BaseTimer Timer(*this);
+				m_pBase->WriteByte(ch);
+				m_Stats.BytesWritten++;
+			}
+
+			void Write(const void *pBuffer, Int64 nLength) override
+			{
+				m_Stats.WriteCalls++;
+				if (m_Histogram) m_Stats.WriteSizes[StreamStatistics::GetBucket(nLength)]++;
+				BaseTimer Timer(*this);
+				m_pBase->Write(pBuffer, nLength);
+				m_Stats.BytesWritten += nLength;
+			}
+
+			void WriteGather(const void *pHead, Int64 nHead, const void *pBody, Int64 nBody) override
+			{
+				m_Stats.WriteCalls++;
+				if (m_Histogram) m_Stats.WriteSizes[StreamStatistics::GetBucket(nHead + nBody)]++;
+				BaseTimer Timer(*this);
+				m_pBase->WriteGather(pHead, nHead, pBody, nBody);
+				m_Stats.BytesWritten += nHead + nBody;
+			}
+
+			void WriteGather(const GatherEntry* pEntries, int nEntries) override
+			{
+				Int64 nTotal = 0;
+				for (int ii = 0; ii < nEntries; ii++) nTotal += pEntries[ii].nLength;
+				m_Stats.WriteCalls++;
+				if (m_Histogram) m_Stats.WriteSizes[StreamStatistics::GetBucket(nTotal)]++;
+				BaseTimer Timer(*this);
+				m_pBase->WriteGather(pEntries, nEntries);
+				m_Stats.BytesWritten += nTotal;
+			}
+
+			Int64 GetPosition() const override { BaseTimer Timer(*this); return m_pBase->GetPosition(); }
+			Int64 GetLength() const override { BaseTimer Timer(*this); return m_pBase->GetLength(); }
+
+			void Seek(Int64 offset, SeekOrigin origin) override
+			{
+				m_Stats.Seeks++;
+				BaseTimer Timer(*this);
+				m_pBase->Seek(offset, origin);
+			}
+
+			bool CanReadDirect() override { return m_pBase->CanReadDirect(); }
+			const byte* ReadDirect(Int64 nLength) override
+			{
+				m_Stats.ReadCalls++;
+				if (m_Histogram) m_Stats.ReadSizes[StreamStatistics::GetBucket(nLength)]++;
+				BaseTimer Timer(*this);
+				const byte* pData = m_pBase->ReadDirect(nLength);
+				if (pData != nullptr) m_Stats.BytesRead += nLength;
+				return pData;
+			}
+
+			const byte* GetReadWindow(Int64& nAvailable) override
+			{
+				m_Stats.ReadWindowCalls++;
+				BaseTimer Timer(*this);
+				return m_pBase->GetReadWindow(nAvailable);
+			}
+			void AdvanceReadWindow(Int64 nBytes) override
+			{
+				m_Stats.BytesRead += nBytes;
+				m_pBase->AdvanceReadWindow(nBytes);
+			}
+
+			void AdviseAccess(AccessPattern Pattern) override { m_pBase->AdviseAccess(Pattern); }
+			void AdviseWillNeed(Int64 Offset, Int64 nLength) override { m_pBase->AdviseWillNeed(Offset, nLength); }
+			void AdviseDontNeed(Int64 Offset, Int64 nLength) override { m_pBase->AdviseDontNeed(Offset, nLength); }
+
+			void Flush() override
+			{
+				m_Stats.Flushes++;
+				BaseTimer Timer(*this);
+				m_pBase->Flush();
+			}
+
+			void Close() override { if (m_pBase.IsAssigned()) m_pBase->Close(); }
+		};
+	}
+}
+
+#endif	// UseSTL
+
+#endif	// __WBInstrumentedStream_h__
+
+//	End of InstrumentedStream.h
@@ -0,0 +1,241 @@
+/*	MappedFileStream.h
+	Copyright (C) 2014 by Wiley Black (TheWiley@gmail.com)
+*/
+
+#ifndef __WBMappedFileStream_h__
+#define __WBMappedFileStream_h__
+
+#include "Streams.h"
+#if !defined(_WINDOWS)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace wb
+{
+	namespace io
+	{
+		/// <summary>MappedFileStream implements the abstract Stream class for read-only access to a file through a memory mapping
+		/// of the entire file.  Reads, seeks, and position queries are performed as pointer arithmetic on the mapped view without
+		/// any system call or copy through the kernel, which makes MappedFileStream well suited to random access over large files.
+		/// The mapped view can also be accessed directly with GetDirectAccess(), in the same manner as MemoryStream, for zero-copy
+		/// consumers.  Pointers obtained from GetDirectAccess() remain valid until the stream is closed.</summary>
+		class MappedFileStream : public Stream
+		{
+			#if defined(_WINDOWS)
+			HANDLE m_hFile;
+			HANDLE m_hMapping;
+			#else
+			int m_Handle;
+			#endif
+
+			const byte*	m_pView;
+			Int64		m_nLength;
+			Int64		m_iPosition;
+
+			#if !defined(_WINDOWS)
+			/// <summary>Passes Advice to madvise() for the pages of the view covering [Offset, Offset + nLength).  Partial pages are
+			/// included when Inclusive is true and excluded otherwise.</summary>
+			void Advise(Int64 Offset, Int64 nLength, int Advice, bool Inclusive)
+			{
+				if (m_pView == nullptr || Offset >= m_nLength || nLength <= 0) return;
+				Int64 PageSize = sysconf(_SC_PAGESIZE);
+				Int64 Start = (Offset < 0) ? 0 : Offset;
+				Int64 End = (nLength > m_nLength - Start) ? m_nLength : Start + nLength;
+				if (Inclusive) Start -= Start % PageSize;
+				else
+				{
+					Start += (PageSize - Start % PageSize) % PageSize;
+					if (End < m_nLength) End -= End % PageSize;
+				}
+				if (End <= Start) return;
+				madvise((void*)(m_pView + Start), (size_t)(End - Start), Advice);
+			}
+			#endif
+
+		public:
+
+			MappedFileStream()
+			{
+				#if defined(_WINDOWS)
+				m_hFile = INVALID_HANDLE_VALUE;
+				m_hMapping = nullptr;
+				#else
+				m_Handle = -1;
+				#endif
+				m_pView = nullptr;
+				m_nLength = m_iPosition = 0;
+			}
+
+			MappedFileStream(const string& sFilename)
+			{
+				#if defined(_WINDOWS)
+				m_hFile = INVALID_HANDLE_VALUE;
+				m_hMapping = nullptr;
+				#else
+				m_Handle = -1;
+				#endif
+				m_pView = nullptr;
+				m_nLength = m_iPosition = 0;
+				Open(sFilename.c_str());
+			}
+
+			MappedFileStream(const MappedFileStream& /*cp*/) { throw Exception("Cannot copy a MappedFileStream object."); }
+			MappedFileStream& operator=(const MappedFileStream& /*cp*/) { throw Exception("Cannot copy a MappedFileStream object."); }
+
+			~MappedFileStream() { Close(); }
+
+			#if defined(_WINDOWS)
+			void Open(const char *pszFilename)
+			{
+				if (pszFilename == nullptr) throw ArgumentException(S("Null value for filename."));
+				Close();
+
+				m_hFile = ::CreateFile(to_osstring(pszFilename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				if (m_hFile == INVALID_HANDLE_VALUE) Exception::ThrowFromWin32(::GetLastError());
+
+				LARGE_INTEGER Size;
+				if (!::GetFileSizeEx(m_hFile, &Size)) { DWORD dwError = ::GetLastError(); Close(); Exception::ThrowFromWin32(dwError); }
+				m_nLength = Size.QuadPart;
+				if (m_nLength == 0) return;			// An empty file cannot be mapped, but needs no view.
+				if ((UInt64)m_nLength > (UInt64)size_t_MaxValue) { Close(); throw IOException(S("File size exceeds platform address space.")); }
+
+				m_hMapping = ::CreateFileMapping(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (m_hMapping == nullptr) { DWORD dwError = ::GetLastError(); Close(); Exception::ThrowFromWin32(dwError); }
+
+				m_pView = (const byte*)::MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+				if (m_pView == nullptr) { DWORD dwError = ::GetLastError(); Close(); Exception::ThrowFromWin32(dwError); }
+			}
+			#else
+			void Open(const char *pszFilename)
+			{
+				if (pszFilename == nullptr) throw ArgumentException(S("Null value for filename."));
+				Close();
+
+				m_Handle = open(pszFilename, O_RDONLY | O_LARGEFILE);
+				if (m_Handle < 0)
+				{
+					m_Handle = -1;
+					switch (errno)
+					{
+					case EACCES: throw UnauthorizedAccessException(S("Unauthorized access."));
+					case EMFILE: throw IOException(S("No more file descriptors available."));
+					case ENOENT: throw FileNotFoundException(S("File or path not found."));
+					default: Exception::ThrowFromErrno(errno);
+					}
+				}
+
+				struct stat64 st;
+				if (fstat64(m_Handle, &st) != 0) { int err = errno; Close(); Exception::ThrowFromErrno(err); }
+				m_nLength = st.st_size;
+				if (m_nLength == 0) return;			// An empty file cannot be mapped, but needs no view.
+				if ((UInt64)m_nLength > (UInt64)size_t_MaxValue) { Close(); throw IOException(S("File size exceeds platform address space.")); }
+
+				void* pView = mmap(nullptr, (size_t)m_nLength, PROT_READ, MAP_SHARED, m_Handle, 0);
+				if (pView == MAP_FAILED) { int err = errno; Close(); Exception::ThrowFromErrno(err); }
+				m_pView = (const byte*)pView;
+			}
+			#endif
+
+			bool CanRead() override { return IsOpen(); }
+			bool CanWrite() override { return false; }
+			bool CanSeek() override { return true; }
+
+			bool IsOpen() const
+			{
+				#if defined(_WINDOWS)
+				return m_hFile != INVALID_HANDLE_VALUE;
+				#else
+				return m_Handle != -1;
+				#endif
+			}
+
+			/// <summary>Reads one byte from the stream and advances to the next byte position, or returns -1 if at the end of stream.</summary>
+			int ReadByte() override
+			{
+				if (m_iPosition >= m_nLength) return -1;
+				return m_pView[m_iPosition++];
+			}
+
+			Int64 Read(void* pBuffer, Int64 nLength) override
+			{
+				Int64 Available = m_nLength - m_iPosition;
+				if (Available <= 0) return 0;
+				if (nLength > Available) nLength = Available;
+				CopyMemory(pBuffer, m_pView + m_iPosition, (size_t)nLength);
+				m_iPosition += nLength;
+				return nLength;
+			}
+
+			bool CanReadDirect() override { return IsOpen(); }
+			const byte* ReadDirect(Int64 nLength) override
+			{
+				if (nLength < 0 || m_iPosition + nLength > m_nLength || m_pView == nullptr) return nullptr;
+				const byte* ret = m_pView + m_iPosition;
+				m_iPosition += nLength;
+				return ret;
+			}
+
+			const byte* GetReadWindow(Int64& nAvailable) override
+			{
+				nAvailable = (m_iPosition < m_nLength) ? (m_nLength - m_iPosition) : 0;
+				return m_pView + m_iPosition;
+			}
+			void AdvanceReadWindow(Int64 nBytes) override { m_iPosition += nBytes; }
+
+			#if !defined(_WINDOWS)
+			void AdviseAccess(AccessPattern Pattern) override
+			{
+				int Advice;
+				switch (Pattern)
+				{
+				case AccessPattern::Sequential: Advice = MADV_SEQUENTIAL; break;
+				case AccessPattern::Random: Advice = MADV_RANDOM; break;
+				default: Advice = MADV_NORMAL; break;
+				}
+				Advise(0, m_nLength, Advice, true);
+			}
+			void AdviseWillNeed(Int64 Offset, Int64 nLength) override { Advise(Offset, nLength, MADV_WILLNEED, true); }
+			void AdviseDontNeed(Int64 Offset, Int64 nLength) override { Advise(Offset, nLength, MADV_DONTNEED, false); }
+			#endif
+
+			Int64 GetPosition() const override { return m_iPosition; }
+			Int64 GetLength() const override { return m_nLength; }
+
+			void Seek(Int64 offset, SeekOrigin origin) override
+			{
+				Int64 Target;
+				switch (origin)
+				{
+				case SeekOrigin::Begin: Target = offset; break;
+				case SeekOrigin::Current: Target = m_iPosition + offset; break;
+				case SeekOrigin::End: Target = m_nLength + offset; break;
+				default: throw ArgumentException(S("Invalid origin."));
+				}
+				if (Target < 0) throw IOException(S("Attempted to seek before the beginning of the stream."));
+				m_iPosition = Target;
+			}
+
+			void Close() override
+			{
+				#if defined(_WINDOWS)
+				if (m_pView != nullptr) { ::UnmapViewOfFile(m_pView); m_pView = nullptr; }
+				if (m_hMapping != nullptr) { ::CloseHandle(m_hMapping); m_hMapping = nullptr; }
+				if (m_hFile != INVALID_HANDLE_VALUE) { ::CloseHandle(m_hFile); m_hFile = INVALID_HANDLE_VALUE; }
+				#else
+				if (m_pView != nullptr) { munmap((void*)m_pView, (size_t)m_nLength); m_pView = nullptr; }
+				if (m_Handle != -1) { close(m_Handle); m_Handle = -1; }
+				#endif
+				m_nLength = m_iPosition = 0;
+			}
+
+			/** Retrieves a pointer into the mapped view at the current position, or at a specified position **/
+			const byte* GetDirectAccess() const { return m_pView + m_iPosition; }
+			const byte* GetDirectAccess(UInt64 AtPosition) const { return m_pView + AtPosition; }
+		};
+	}
+}
+
+#endif	// __WBMappedFileStream_h__
+
+//	End of MappedFileStream.h
@@ -15,7 +15,8 @@ namespace wb
 	{
 		/// <summary>MemoryStream implements the Stream abstract class using memory as the stream's backing store.  Reading and writing is performed into
 		/// a memory buffer, which expands as necessary to contain the full stream.  The MemoryStream class is modeled after the .NET System.IO.MemoryStream 
-		/// class and a google search will provide similar examples (except this is native code and has no .NET dependency).</summary>
+		/// class and a google search will provide similar examples (except this is native code and has no .NET dependency).  Growing
+		/// the buffer moves its content; see ChunkedMemoryStream for very large streams.</summary>
 		class MemoryStream : public Stream
 		{
 			wb::memory::Buffer	m_Buffer;
@@ -33,6 +34,8 @@ namespace wb
 				if (ret < 65536) return 65536;
 				if (ret < 262144) return 262144;
 				if (ret < 1048576) return 1048576;		// 1MB
+				UInt64 Geometric = m_Buffer.GetSize() + m_Buffer.GetSize() / 2;
+				if (ret < Geometric) ret = Geometric;	// Grow by at least half so that appending is not quadratic.
 				return (ret & ~0xFFFFF) + 0x100000;		// Round up to next MB.
 			}
 
@@ -116,6 +119,37 @@ namespace wb
 				m_iPosition += nLength;
 				if (m_iPosition > m_nLength) m_nLength = m_iPosition;
 			}
+			void WriteGather(const void *pHead, Int64 nHead, const void *pBody, Int64 nBody) override
+			{
+				// Grow once for both blocks.
+				if (m_iPosition + nHead + nBody > m_Buffer.GetSize()) m_Buffer.Realloc(GetNextCapacity(nHead + nBody));
+				Write(pHead, nHead);
+				Write(pBody, nBody);
+			}
+			void WriteGather(const GatherEntry* pEntries, int nEntries) override
+			{
+				// Grow once for all blocks.
+				Int64 nTotal = 0;
+				for (int ii = 0; ii < nEntries; ii++) nTotal += pEntries[ii].nLength;
+				if (m_iPosition + nTotal > m_Buffer.GetSize()) m_Buffer.Realloc(GetNextCapacity(nTotal));
+				for (int ii = 0; ii < nEntries; ii++) Write(pEntries[ii].pData, pEntries[ii].nLength);
+			}
+
+			bool CanReadDirect() override { return true; }
+			const byte* ReadDirect(Int64 nLength) override
+			{
+				if (nLength < 0 || m_iPosition + nLength > m_nLength) return nullptr;
+				const byte* ret = ((const byte*)m_Buffer.At()) + m_iPosition;
+				m_iPosition += nLength;
+				return ret;
+			}
+
+			const byte* GetReadWindow(Int64& nAvailable) override
+			{
+				nAvailable = (m_iPosition < m_nLength) ? (Int64)(m_nLength - m_iPosition) : 0;
+				return ((const byte*)m_Buffer.At()) + m_iPosition;
+			}
+			void AdvanceReadWindow(Int64 nBytes) override { m_iPosition += nBytes; }
 
 			Int64 GetPosition() const override { return m_iPosition; }
 			Int64 GetCapacity() const { return m_Buffer.GetSize(); }
@@ -0,0 +1,298 @@
+/*	PrefetchStream.h
+	Copyright (C) 2014 by Wiley Black (TheWiley@gmail.com)
+*/
+
+#ifndef __WBPrefetchStream_h__
+#define __WBPrefetchStream_h__
+
+#include "Streams.h"
+#include "../Memory Management/Allocation.h"
+#include "../Memory Management/Buffer.h"
+
+#if defined(UseSTL)
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <vector>
+
+namespace wb
+{
+	namespace io
+	{
+		/// <summary>PrefetchStream provides read-ahead on top of another stream for sequential reading.  A background thread reads
+		/// from the underlying stream into a ring of buffers while the caller consumes data from the buffer at the front of the ring,
+		/// so that I/O on the underlying stream overlaps with parsing instead of being serialized with it.  PrefetchStream is
+		/// read-only.  Seeking is supported if the underlying stream supports it: seeks that land within the current buffer are
+		/// performed in memory, while other seeks halt the background thread, reposition the underlying stream, and restart
+		/// read-ahead from the new position.  An error encountered by the background thread is rethrown to the caller when the
+		/// caller reaches the data that could not be read.  While wrapped, the underlying stream must not be accessed directly as it
+		/// is in use by the background thread.</summary>
+		class PrefetchStream : public Stream
+		{
+			memory::r_ptr<Stream>	m_pBase;
+			memory::Buffer			m_Storage;
+			UInt32					m_BufferSize;
+			UInt32					m_nBuffers;
+
+			/** Shared state, guarded by m_Lock **/
+
+			std::mutex					m_Lock;
+			std::condition_variable		m_Filled;			// Signalled by the background thread when a buffer is ready or reading ends.
+			std::condition_variable		m_Released;			// Signalled by the caller when a buffer is released or on stop.
+			std::vector<Int64>			m_Fill;				// Number of valid bytes in each buffer of the ring.
+			UInt32						m_iFront;			// Index of the buffer at the front of the ring.
+			UInt32						m_nReady;			// Number of filled buffers, starting at m_iFront.
+			bool						m_Stop;
+			bool						m_EndOfStream;		// The background thread has reached the end of the stream or an error.
+			std::exception_ptr			m_pError;
+			std::thread					m_Thread;
+
+			/** Caller state **/
+
+			// When m_HoldsFront is true, the caller is consuming bytes [m_iRead, m_nRead) of the front buffer at m_pCurrent, and
+			// m_CurrentPosition gives the position within the underlying stream of m_pCurrent[0].
+			bool			m_HoldsFront;
+			const byte*		m_pCurrent;
+			Int64			m_iRead;
+			Int64			m_nRead;
+			Int64			m_CurrentPosition;
+
+			byte* GetBuffer(UInt32 Index) { return ((byte*)m_Storage.At()) + (size_t)Index * m_BufferSize; }
+
+			void ReadAhead()
+			{
+				for (;;)
+				{
+					UInt32 iFill;
+					{
+						std::unique_lock<std::mutex> lock(m_Lock);
+						m_Released.wait(lock, [this] { return m_Stop || m_nReady < m_nBuffers; });
+						if (m_Stop) return;
+						iFill = (m_iFront + m_nReady) % m_nBuffers;
+					}
+
+					Int64 nRead;
+					try
+					{
+						nRead = m_pBase->Read(GetBuffer(iFill), m_BufferSize);
+					}
+					catch (...)
+					{
+						std::lock_guard<std::mutex> lock(m_Lock);
+						m_pError = std::current_exception();
+						m_EndOfStream = true;
+						m_Filled.notify_one();
+						return;
+					}
+
+					std::lock_guard<std::mutex> lock(m_Lock);
+					if (nRead <= 0) { m_EndOfStream = true; m_Filled.notify_one(); return; }
+					m_Fill[iFill] = nRead;
+					m_nReady ++;
+					m_Filled.notify_one();
+				}
+			}
+
+			/// <summary>Releases the front buffer, if held, and waits for the next one.  Returns false at the end of the stream.</summary>
+			bool NextBuffer()
+			{
+				std::unique_lock<std::mutex> lock(m_Lock);
+				if (m_HoldsFront)
+				{
+					m_CurrentPosition += m_nRead;
+					m_iFront = (m_iFront + 1) % m_nBuffers;
+					m_nReady --;
+					m_HoldsFront = false;
+					m_iRead = m_nRead = 0;
+					m_Released.notify_one();
+				}
+				m_Filled.wait(lock, [this] { return m_nReady > 0 || m_EndOfStream; });
+				if (m_nReady == 0)
+				{
+					if (m_pError) { std::exception_ptr pError = m_pError; m_pError = nullptr; std::rethrow_exception(pError); }
+					return false;
+				}
+				m_HoldsFront = true;
+				m_pCurrent = GetBuffer(m_iFront);
+				m_iRead = 0;
+				m_nRead = m_Fill[m_iFront];
+				return true;
+			}
+
+			/// <summary>Discards all buffered data and begins reading ahead from the underlying stream's current position.</summary>
+			void StartReadAhead()
+			{
+				m_iFront = m_nReady = 0;
+				m_EndOfStream = false;
+				m_pError = nullptr;
+				m_HoldsFront = false;
+				m_pCurrent = nullptr;
+				m_iRead = m_nRead = 0;
+				ResumeReadAhead();
+			}
+
+			/// <summary>Restarts the background thread after StopReadAhead(), keeping the data already buffered.</summary>
+			void ResumeReadAhead()
+			{
+				m_Stop = false;
+				if (!m_EndOfStream) m_Thread = std::thread(&PrefetchStream::ReadAhead, this);
+			}
+
+			void StopReadAhead()
+			{
+				if (!m_Thread.joinable()) return;
+				{
+					std::lock_guard<std::mutex> lock(m_Lock);
+					m_Stop = true;
+					m_Released.notify_one();
+				}
+				m_Thread.join();
+			}
+
+			/// <summary>Halts read-ahead, repositions the underlying stream, and restarts read-ahead from the new position.  If the
+			/// underlying stream fails to seek, read-ahead resumes from where it stopped before the error is rethrown.</summary>
+			void SeekBase(Int64 offset, SeekOrigin origin)
+			{
+				StopReadAhead();
+				try
+				{
+					m_pBase->Seek(offset, origin);
+					m_CurrentPosition = m_pBase->GetPosition();
+				}
+				catch (...)
+				{
+					ResumeReadAhead();
+					throw;
+				}
+				StartReadAhead();
+			}
+
+		public:
+
+			/// <summary>The buffer size and buffer count used when none are specified.</summary>
+			static const UInt32 DefaultBufferSize = 1048576;			// 1MB
+			static const UInt32 DefaultBufferCount = 4;
+
+			/// <summary>Constructs a PrefetchStream that reads ahead from the current position of Base.  Read-ahead begins
+			/// immediately.</summary>
+			PrefetchStream(memory::r_ptr<Stream>&& Base, UInt32 BufferSize = DefaultBufferSize, UInt32 BufferCount = DefaultBufferCount)
+				: m_pBase(std::move(Base))
+			{
+				m_BufferSize = (BufferSize > 0) ? BufferSize : 1;
+				m_nBuffers = (BufferCount > 1) ? BufferCount : 2;
+				m_Storage.Alloc((UInt64)m_BufferSize * m_nBuffers);
+				m_Fill.resize(m_nBuffers, 0);
+				m_CurrentPosition = m_pBase->CanSeek() ? m_pBase->GetPosition() : 0;
+				StartReadAhead();
+			}
+
+			PrefetchStream(const PrefetchStream& /*cp*/) { throw Exception("Cannot copy a PrefetchStream object."); }
+			PrefetchStream& operator=(const PrefetchStream& /*cp*/) { throw Exception("Cannot copy a PrefetchStream object."); }
+
+			~PrefetchStream()
+			{
+				// The base stream is not closed here, as it may be owned elsewhere, but the background thread must finish with it.
+				StopReadAhead();
+			}
+
+			bool CanRead() override { return true; }
+			bool CanWrite() override { return false; }
+			bool CanSeek() override { return m_pBase->CanSeek(); }
+
+			/// <summary>Reads one byte from the stream and advances to the next byte position, or returns -1 if at the end of stream.</summary>
+			int ReadByte() override
+			{
+				if (m_iRead < m_nRead) return m_pCurrent[m_iRead++];
+				if (!NextBuffer()) return -1;
+				return m_pCurrent[m_iRead++];
+			}
+
+			Int64 Read(void* pBuffer, Int64 nLength) override
+			{
+				byte* pDst = (byte*)pBuffer;
+				Int64 count = 0;
+				while (count < nLength)
+				{
+					if (m_iRead == m_nRead && !NextBuffer()) return count;
+					Int64 nCopy = m_nRead - m_iRead;
+					if (nCopy > nLength - count) nCopy = nLength - count;
+					CopyMemory(pDst + count, m_pCurrent + m_iRead, (size_t)nCopy);
+					m_iRead += nCopy;
+					count += nCopy;
+				}
+				return count;
+			}
+
+			const byte* GetReadWindow(Int64& nAvailable) override
+			{
+				if (m_iRead == m_nRead) NextBuffer();
+				nAvailable = m_nRead - m_iRead;
+				return m_pCurrent + m_iRead;
+			}
+			void AdvanceReadWindow(Int64 nBytes) override { m_iRead += nBytes; }
+
+			// Advice is passed to the underlying stream while the background thread may be reading from it.  FileStream,
+			// MappedFileStream, and BufferedStream over either accept advice concurrently with a read.
+			void AdviseAccess(AccessPattern Pattern) override { m_pBase->AdviseAccess(Pattern); }
+			void AdviseWillNeed(Int64 Offset, Int64 nLength) override { m_pBase->AdviseWillNeed(Offset, nLength); }
+			void AdviseDontNeed(Int64 Offset, Int64 nLength) override { m_pBase->AdviseDontNeed(Offset, nLength); }
+
+			Int64 GetPosition() const override { return m_CurrentPosition + m_iRead; }
+
+			Int64 GetLength() const override
+			{
+				// The underlying stream may reposition itself while measuring its length, so read-ahead is halted around the call.
+				PrefetchStream* pThis = const_cast<PrefetchStream*>(this);
+				pThis->StopReadAhead();
+				Int64 Length;
+				try
+				{
+					Length = m_pBase->GetLength();
+				}
+				catch (...)
+				{
+					pThis->ResumeReadAhead();
+					throw;
+				}
+				pThis->ResumeReadAhead();
+				return Length;
+			}
+
+			void Seek(Int64 offset, SeekOrigin origin) override
+			{
+				Int64 Target;
+				switch (origin)
+				{
+				case SeekOrigin::Begin: Target = offset; break;
+				case SeekOrigin::Current: Target = GetPosition() + offset; break;
+				case SeekOrigin::End: SeekBase(offset, SeekOrigin::End); return;
+				default: throw ArgumentException(S("Invalid origin."));
+				}
+
+				// If the target lies within the current buffer, only the read index changes.
+				if (m_HoldsFront && Target >= m_CurrentPosition && Target <= m_CurrentPosition + m_nRead)
+				{
+					m_iRead = Target - m_CurrentPosition;
+					return;
+				}
+
+				SeekBase(Target, SeekOrigin::Begin);
+			}
+
+			void Close() override
+			{
+				StopReadAhead();
+				m_HoldsFront = false;
+				m_iRead = m_nRead = 0;
+				if (m_pBase.IsAssigned()) m_pBase->Close();
+			}
+		};
+	}
+}
+
+#endif	// UseSTL
+
+#endif	// __WBPrefetchStream_h__
+
+//	End of PrefetchStream.h
@@ -0,0 +1,317 @@
+/*	SharedFileStream.h
+	Copyright (C) 2014 by Wiley Black (TheWiley@gmail.com)
+*/
+
+#ifndef __WBSharedFileStream_h__
+#define __WBSharedFileStream_h__
+
+#include "Streams.h"
+#include "../Memory Management/Buffer.h"
+#if !defined(_WINDOWS)
+#include <sys/stat.h>
+#endif
+
+namespace wb
+{
+	namespace io
+	{
+		/// <summary>SharedFile is a file opened for reading that any number of threads can read concurrently.  It has no file
+		/// position: each read names its own offset (pread() on Linux, an OVERLAPPED offset on Windows), so readers never disturb
+		/// one another.  Use SharedFileStream to read a SharedFile through the Stream interface, with one SharedFileStream per
+		/// reader.</summary>
+		class SharedFile
+		{
+			#if defined(_WINDOWS)
+			HANDLE m_Handle;
+			#else
+			int m_Handle;
+			#endif
+
+		public:
+
+			SharedFile()
+			{
+				#if defined(_WINDOWS)
+				m_Handle = INVALID_HANDLE_VALUE;
+				#else
+				m_Handle = -1;
+				#endif
+			}
+
+			SharedFile(const string& sFilename)
+			{
+				#if defined(_WINDOWS)
+				m_Handle = INVALID_HANDLE_VALUE;
+				#else
+				m_Handle = -1;
+				#endif
+				Open(sFilename.c_str());
+			}
+
+			SharedFile(const SharedFile& /*cp*/) { throw Exception("Cannot copy a SharedFile object."); }
+			SharedFile& operator=(const SharedFile& /*cp*/) { throw Exception("Cannot copy a SharedFile object."); }
+
+			~SharedFile() { Close(); }
+
+			#if defined(_WINDOWS)
+			void Open(const char *pszFilename)
+			{
+				if (pszFilename == nullptr) throw ArgumentException(S("Null value for filename."));
+				Close();
+				m_Handle = ::CreateFile(to_osstring(pszFilename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				if (m_Handle == INVALID_HANDLE_VALUE) Exception::ThrowFromWin32(::GetLastError());
+			}
+			#else
+			void Open(const char *pszFilename)
+			{
+				if (pszFilename == nullptr) throw ArgumentException(S("Null value for filename."));
+				Close();
+
+				m_Handle = open(pszFilename, O_RDONLY | O_LARGEFILE);
+				if (m_Handle >= 0) return;
+
+				m_Handle = -1;
+				switch (errno)
+				{
+				case EACCES: throw UnauthorizedAccessException(S("Unauthorized access."));
+				case EMFILE: throw IOException(S("No more file descriptors available."));
+				case ENOENT: throw FileNotFoundException(S("File or path not found."));
+				default: Exception::ThrowFromErrno(errno);
+				}
+			}
+			#endif
+
+			bool IsOpen() const
+			{
+				#if defined(_WINDOWS)
+				return m_Handle != INVALID_HANDLE_VALUE;
+				#else
+				return m_Handle != -1;
+				#endif
+			}
+
+			/// <summary>Reads up to nLength bytes beginning at Offset in the file.  ReadAt() may be called from any number of threads
+			/// at once.</summary>
+			/// <returns>The number of bytes read, which is less than nLength only at the end of the file.</returns>
+			Int64 ReadAt(Int64 Offset, void* pBuffer, Int64 nLength) const
+			{
+				byte* pDst = (byte*)pBuffer;
+				Int64 count = 0;
+				while (count < nLength)
+				{
+					Int64 nBlock = nLength - count;
+					if (nBlock > Int32_MaxValue) nBlock = Int32_MaxValue;
+					#if defined(_WINDOWS)
+					OVERLAPPED ov;
+					ZeroMemory(&ov, sizeof(ov));
+					ov.Offset = (DWORD)(Offset + count);
+					ov.OffsetHigh = (DWORD)((Offset + count) >> 32);
+					DWORD block_count;
+					if (!::ReadFile(m_Handle, pDst + count, (DWORD)nBlock, &block_count, &ov))
+					{
+						DWORD dwError = ::GetLastError();
+						if (dwError == ERROR_HANDLE_EOF) return count;
+						Exception::ThrowFromWin32(dwError);
+					}
+					#else
+					Int64 block_count = pread64(m_Handle, pDst + count, (size_t)nBlock, Offset + count);
+					if (block_count < 0)
+					{
+						if (errno == EINTR) continue;
+						Exception::ThrowFromErrno(errno);
+					}
+					#endif
+					if (block_count == 0) return count;
+					count += block_count;
+				}
+				return count;
+			}
+
+			Int64 GetLength() const
+			{
+				#if defined(_WINDOWS)
+				LARGE_INTEGER size;
+				if (!::GetFileSizeEx(m_Handle, &size)) Exception::ThrowFromWin32(::GetLastError());
+				return size.QuadPart;
+				#else
+				struct stat64 st;
+				if (fstat64(m_Handle, &st) != 0) Exception::ThrowFromErrno(errno);
+				return st.st_size;
+				#endif
+			}
+
+			/** Access hints, as described by Stream::AdviseAccess() and related calls.  Advice given for the file applies to all of its
+				readers.  On Windows, access hints are given only when a file is opened and these calls have no effect. **/
+
+			void AdviseAccess(AccessPattern Pattern) const
+			{
+				#if !defined(_WINDOWS)
+				int Advice;
+				switch (Pattern)
+				{
+				case AccessPattern::Sequential: Advice = POSIX_FADV_SEQUENTIAL; break;
+				case AccessPattern::Random: Advice = POSIX_FADV_RANDOM; break;
+				default: Advice = POSIX_FADV_NORMAL; break;
+				}
+				posix_fadvise64(m_Handle, 0, 0, Advice);
+				#endif
+			}
+
+			void AdviseWillNeed(Int64 Offset, Int64 nLength) const
+			{
+				#if !defined(_WINDOWS)
+				posix_fadvise64(m_Handle, Offset, nLength, POSIX_FADV_WILLNEED);
+				#endif
+			}
+
+			void AdviseDontNeed(Int64 Offset, Int64 nLength) const
+			{
+				#if !defined(_WINDOWS)
+				posix_fadvise64(m_Handle, Offset, nLength, POSIX_FADV_DONTNEED);
+				#endif
+			}
+
+			void Close()
+			{
+				#if defined(_WINDOWS)
+				if (m_Handle != INVALID_HANDLE_VALUE) { ::CloseHandle(m_Handle); m_Handle = INVALID_HANDLE_VALUE; }
+				#else
+				if (m_Handle != -1) { close(m_Handle); m_Handle = -1; }
+				#endif
+			}
+		};
+
+		/// <summary>SharedFileStream reads a SharedFile through the Stream interface, keeping its own position and its own read
+		/// buffer.  Many SharedFileStreams, each used by one thread, can read the same SharedFile concurrently, for example to parse
+		/// independent top-level containers of a DML file in parallel with one DmlReader each, without opening the file more than
+		/// once.  The SharedFile must remain open until all of its streams are closed, and is not closed by them.  SharedFileStream
+		/// is read-only.</summary>
+		class SharedFileStream : public Stream
+		{
+			const SharedFile*		m_pFile;
+			memory::Buffer			m_Buffer;
+
+			// Bytes [0, m_nRead) of m_Buffer hold the file content beginning at m_BufferPosition, of which [0, m_iRead) have been
+			// consumed.
+			Int64	m_BufferPosition;
+			Int64	m_iRead;
+			Int64	m_nRead;
+
+			bool FillBuffer()
+			{
+				m_BufferPosition += m_nRead;
+				m_iRead = 0;
+				m_nRead = m_pFile->ReadAt(m_BufferPosition, m_Buffer.At(), m_Buffer.GetSize());
+				return (m_nRead > 0);
+			}
+
+		public:
+
+			/// <summary>The buffer size used when none is specified.</summary>
+			static const UInt32 DefaultBufferSize = 65536;			// 64KB
+
+			/// <summary>Constructs a SharedFileStream reading File, beginning at StartPosition.  A BufferSize of zero selects
+			/// DefaultBufferSize.</summary>
+			SharedFileStream(const SharedFile& File, Int64 StartPosition = 0, UInt32 BufferSize = DefaultBufferSize)
+				: m_pFile(&File), m_Buffer(BufferSize > 0 ? BufferSize : DefaultBufferSize)
+			{
+				if (!File.IsOpen()) throw ArgumentException(S("SharedFile is not open."));
+				m_BufferPosition = StartPosition;
+				m_iRead = m_nRead = 0;
+			}
+
+			SharedFileStream(const SharedFileStream& /*cp*/) { throw Exception("Cannot copy a SharedFileStream object."); }
+			SharedFileStream& operator=(const SharedFileStream& /*cp*/) { throw Exception("Cannot copy a SharedFileStream object."); }
+
+			bool CanRead() override { return m_pFile != nullptr; }
+			bool CanWrite() override { return false; }
+			bool CanSeek() override { return true; }
+
+			/// <summary>Reads one byte from the stream and advances to the next byte position, or returns -1 if at the end of stream.</summary>
+			int ReadByte() override
+			{
+				if (m_iRead < m_nRead) return ((byte*)m_Buffer.At())[m_iRead++];
+				if (!FillBuffer()) return -1;
+				return ((byte*)m_Buffer.At())[m_iRead++];
+			}
+
+			Int64 Read(void* pBuffer, Int64 nLength) override
+			{
+				byte* pDst = (byte*)pBuffer;
+				Int64 count = 0;
+				while (count < nLength)
+				{
+					if (m_iRead < m_nRead)
+					{
+						Int64 nCopy = m_nRead - m_iRead;
+						if (nCopy > nLength - count) nCopy = nLength - count;
+						CopyMemory(pDst + count, ((byte*)m_Buffer.At()) + m_iRead, (size_t)nCopy);
+						m_iRead += nCopy;
+						count += nCopy;
+						continue;
+					}
+
+					// Large requests bypass the buffer to avoid an extra copy.
+					if (nLength - count >= (Int64)m_Buffer.GetSize())
+					{
+						m_BufferPosition += m_nRead;
+						m_iRead = m_nRead = 0;
+						Int64 nRead = m_pFile->ReadAt(m_BufferPosition, pDst + count, nLength - count);
+						m_BufferPosition += nRead;
+						return count + nRead;
+					}
+
+					if (!FillBuffer()) return count;
+				}
+				return count;
+			}
+
+			const byte* GetReadWindow(Int64& nAvailable) override
+			{
+				if (m_iRead == m_nRead) FillBuffer();
+				nAvailable = m_nRead - m_iRead;
+				return ((const byte*)m_Buffer.At()) + m_iRead;
+			}
+			void AdvanceReadWindow(Int64 nBytes) override { m_iRead += nBytes; }
+
+			void AdviseAccess(AccessPattern Pattern) override { m_pFile->AdviseAccess(Pattern); }
+			void AdviseWillNeed(Int64 Offset, Int64 nLength) override { m_pFile->AdviseWillNeed(Offset, nLength); }
+			void AdviseDontNeed(Int64 Offset, Int64 nLength) override { m_pFile->AdviseDontNeed(Offset, nLength); }
+
+			Int64 GetPosition() const override { return m_BufferPosition + m_iRead; }
+			Int64 GetLength() const override { return m_pFile->GetLength(); }
+
+			void Seek(Int64 offset, SeekOrigin origin) override
+			{
+				Int64 Target;
+				switch (origin)
+				{
+				case SeekOrigin::Begin: Target = offset; break;
+				case SeekOrigin::Current: Target = GetPosition() + offset; break;
+				case SeekOrigin::End: Target = m_pFile->GetLength() + offset; break;
+				default: throw ArgumentException(S("Invalid origin."));
+				}
+				if (Target < 0) throw IOException(S("Attempted to seek before the beginning of the stream."));
+
+				// If the target lies within the buffer, only the read index changes.
+				if (Target >= m_BufferPosition && Target <= m_BufferPosition + m_nRead)
+				{
+					m_iRead = Target - m_BufferPosition;
+					return;
+				}
+				m_BufferPosition = Target;
+				m_iRead = m_nRead = 0;
+			}
+
+			void Close() override
+			{
+				m_pFile = nullptr;
+				m_iRead = m_nRead = 0;
+			}
+		};
+	}
+}
+
+#endif	// __WBSharedFileStream_h__
+
+//	End of SharedFileStream.h
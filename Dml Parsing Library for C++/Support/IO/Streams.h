@@ -33,6 +33,35 @@ namespace wb
 		}
 		enum_class_end(SeekOrigin);		
 
+		enum_class_start(AccessPattern, int)
+		{
+			/// <summary>No particular access pattern is expected.</summary>
+			Normal,
+
+			/// <summary>The stream will be read from lower to higher positions.</summary>
+			Sequential,
+
+			/// <summary>The stream will be read at scattered positions.</summary>
+			Random
+		}
+		enum_class_end(AccessPattern);
+
+		/// <summary>GatherEntry describes one block of a gathered write, in the manner of an iovec.</summary>
+		struct GatherEntry
+		{
+			const void*	pData;
+			Int64		nLength;
+		};
+
+		/// <summary>MaxGatherEntries is the largest number of blocks that a stream submits to the operating system in one call.  
+		/// WriteGather() accepts any number of entries, and callers that assemble entries in batches can use it as the batch 
+		/// size.</summary>
+		#if defined(IOV_MAX)
+		static const int MaxGatherEntries = IOV_MAX;
+		#else
+		static const int MaxGatherEntries = 16;
+		#endif
+
 		/// <summary>Stream provides the virtual (abstract) base class for any streams of data.  Streams can include memory, file, or network
 		/// data.  Stream cannot be instantiated directly, and instead a concrete class such as FileStream or MemoryStream should be used.
 		/// Streams provide read, write, and seek capabilities where the underlying stream supports it (query CanRead(), CanWrite(), and
@@ -73,10 +102,59 @@ namespace wb
 				while (nLength--) WriteByte(*pb++); 
 			}
 
+			/// <summary>WriteGather() writes two blocks, such as a small header followed by a large payload, with the same result as two
+			/// consecutive Write() calls.  Streams that can submit both blocks to the underlying device in a single operation, without
+			/// first copying them together, override WriteGather().</summary>
+			virtual void WriteGather(const void *pHead, Int64 nHead, const void *pBody, Int64 nBody)
+			{
+				Write(pHead, nHead);
+				Write(pBody, nBody);
+			}
+
+			/// <summary>This form of WriteGather() writes a list of nEntries blocks, with the same result as a Write() call for each 
+			/// entry in order.</summary>
+			virtual void WriteGather(const GatherEntry* pEntries, int nEntries)
+			{
+				for (int ii = 0; ii < nEntries; ii++) Write(pEntries[ii].pData, pEntries[ii].nLength);
+			}
+
 			virtual Int64 GetPosition() const { throw NotSupportedException(); }
 			virtual Int64 GetLength() const { throw NotSupportedException(); }
 			virtual void Seek(Int64 offset, SeekOrigin origin) { throw NotSupportedException(); }
 
+			/// <summary>CanReadDirect() indicates that the stream's content is held in memory that remains valid while the stream is
+			/// open, so that ReadDirect() can provide data in place instead of copying it.</summary>
+			virtual bool CanReadDirect() { return false; }
+
+			/// <summary>ReadDirect() provides a pointer to the next nLength bytes of the stream within the stream's own storage and 
+			/// advances past them.  The pointer remains valid while the stream is open and not written to.</summary>
+			/// <returns>A pointer to the data, or nullptr without advancing if the stream does not support direct reads or if fewer
+			/// than nLength bytes remain in the stream.</returns>
+			virtual const byte* ReadDirect(Int64 /*nLength*/) { return nullptr; }
+
+			/// <summary>GetReadWindow() provides access to bytes that are already in memory at the current position, without consuming
+			/// them, so that parsers can decode directly from the stream's buffer.  The window is valid only until the next call on the
+			/// stream other than AdvanceReadWindow().  Streams that do not buffer in memory provide no window.</summary>
+			/// <returns>A pointer to the window, or nullptr with nAvailable set to zero if no window is available.</returns>
+			virtual const byte* GetReadWindow(Int64& nAvailable) { nAvailable = 0; return nullptr; }
+
+			/// <summary>AdvanceReadWindow() consumes nBytes from the start of the window returned by GetReadWindow().  nBytes must not 
+			/// exceed the available window.</summary>
+			virtual void AdvanceReadWindow(Int64 /*nBytes*/) { throw NotSupportedException(); }
+
+			/// <summary>AdviseAccess() tells the stream how its content is about to be read, so that the operating system can tune
+			/// read-ahead and caching.  Advice is only a hint: it never changes the data read, and streams that cannot use it ignore
+			/// it.</summary>
+			virtual void AdviseAccess(AccessPattern /*Pattern*/) { }
+
+			/// <summary>AdviseWillNeed() hints that nLength bytes beginning at stream position Offset will be read soon, so that the
+			/// operating system can begin loading them.</summary>
+			virtual void AdviseWillNeed(Int64 /*Offset*/, Int64 /*nLength*/) { }
+
+			/// <summary>AdviseDontNeed() hints that nLength bytes beginning at stream position Offset will not be read again soon,
+			/// so that the operating system can drop them from its cache.</summary>
+			virtual void AdviseDontNeed(Int64 /*Offset*/, Int64 /*nLength*/) { }
+
 			virtual void Flush() { }
 			virtual void Close() { }
 		};				
@@ -0,0 +1,254 @@
+/*	WriteBehindStream.h
+	Copyright (C) 2014 by Wiley Black (TheWiley@gmail.com)
+*/
+
+#ifndef __WBWriteBehindStream_h__
+#define __WBWriteBehindStream_h__
+
+#include "Streams.h"
+#include "../Memory Management/Allocation.h"
+#include "../Memory Management/Buffer.h"
+
+#if defined(UseSTL)
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <vector>
+
+namespace wb
+{
+	namespace io
+	{
+		/// <summary>WriteBehindStream decouples writers from the latency of another stream.  Writes are copied into a ring of buffers
+		/// that a background thread passes to the underlying stream, so that WriteByte() and Write() return as soon as the data is
+		/// in memory.  Memory use is bounded by the buffer size and count given at construction; when every buffer is waiting to be
+		/// written, the writer blocks until the background thread frees one.  The writer synchronizes with the background thread only
+		/// when a buffer is handed over, not on each write.  Flush() and Close() wait until all data has been written and then flush
+		/// the underlying stream.  Seeking is supported if the underlying stream supports it, and first waits for all pending data to
+		/// be written, so that back-patching (such as DmlWriter::Seek()) sees a consistent stream.  An error encountered by the
+		/// background thread is rethrown to the writer on its next hand-over, Flush(), Seek() or Close().  While wrapped, the
+		/// underlying stream must not be accessed directly.  WriteBehindStream is write-only.</summary>
+		class WriteBehindStream : public Stream
+		{
+			memory::r_ptr<Stream>	m_pBase;
+			memory::Buffer			m_Storage;
+			UInt32					m_BufferSize;
+			UInt32					m_nBuffers;
+
+			/** Shared state, guarded by m_Lock **/
+
+			std::mutex					m_Lock;
+			std::condition_variable		m_Queued;			// Signalled by the writer when a buffer is handed over or on stop.
+			std::condition_variable		m_Written;			// Signalled by the background thread when a buffer has been written.
+			std::vector<Int64>			m_Fill;				// Number of valid bytes in each buffer of the ring.
+			UInt32						m_iFront;			// Index of the oldest buffer waiting to be written.
+			UInt32						m_nQueued;			// Number of buffers waiting to be written, starting at m_iFront.
+			bool						m_Stop;
+			std::exception_ptr			m_pError;
+			std::thread					m_Thread;
+
+			/** Writer state **/
+
+			// The writer owns buffer m_iCurrent, of which [0, m_nWrite) has been written.  m_Position is the logical stream position.
+			UInt32			m_iCurrent;
+			byte*			m_pCurrent;
+			Int64			m_nWrite;
+			Int64			m_Position;
+
+			byte* GetBuffer(UInt32 Index) { return ((byte*)m_Storage.At()) + (size_t)Index * m_BufferSize; }
+
+			void WriteBehind()
+			{
+				for (;;)
+				{
+					UInt32 iWrite;
+					{
+						std::unique_lock<std::mutex> lock(m_Lock);
+						m_Queued.wait(lock, [this] { return m_Stop || m_nQueued > 0; });
+						if (m_nQueued == 0) return;			// Stopped and drained.
+						iWrite = m_iFront;
+					}
+
+					try
+					{
+						m_pBase->Write(GetBuffer(iWrite), m_Fill[iWrite]);
+					}
+					catch (...)
+					{
+						// Data queued behind the failure is discarded, as it can no longer be written in order.
+						std::lock_guard<std::mutex> lock(m_Lock);
+						m_pError = std::current_exception();
+						m_iFront = (m_iFront + m_nQueued) % m_nBuffers;
+						m_nQueued = 0;
+						m_Written.notify_one();
+						continue;
+					}
+
+					std::lock_guard<std::mutex> lock(m_Lock);
+					m_iFront = (m_iFront + 1) % m_nBuffers;
+					m_nQueued --;
+					m_Written.notify_one();
+				}
+			}
+
+			void ThrowPendingError()
+			{
+				if (!m_pError) return;
+				std::exception_ptr pError = m_pError;
+				m_pError = nullptr;
+				std::rethrow_exception(pError);
+			}
+
+			/// <summary>Hands the writer's current buffer to the background thread, if it holds data, and waits for a free buffer.</summary>
+			void HandOver()
+			{
+				std::unique_lock<std::mutex> lock(m_Lock);
+				if (m_nWrite > 0)
+				{
+					m_Fill[m_iCurrent] = m_nWrite;
+					m_nQueued ++;
+					m_nWrite = 0;
+					m_Queued.notify_one();
+				}
+				m_Written.wait(lock, [this] { return m_nQueued < m_nBuffers; });
+				m_iCurrent = (m_iFront + m_nQueued) % m_nBuffers;
+				m_pCurrent = GetBuffer(m_iCurrent);
+				ThrowPendingError();
+			}
+
+			/// <summary>Hands over any buffered data and waits until the background thread has written all of it.</summary>
+			void Drain()
+			{
+				std::unique_lock<std::mutex> lock(m_Lock);
+				if (m_nWrite > 0)
+				{
+					m_Fill[m_iCurrent] = m_nWrite;
+					m_nQueued ++;
+					m_nWrite = 0;
+					m_Queued.notify_one();
+				}
+				m_Written.wait(lock, [this] { return m_nQueued == 0; });
+				m_iCurrent = m_iFront;
+				m_pCurrent = GetBuffer(m_iCurrent);
+				ThrowPendingError();
+			}
+
+			void StopWriteBehind()
+			{
+				if (!m_Thread.joinable()) return;
+				{
+					std::lock_guard<std::mutex> lock(m_Lock);
+					m_Stop = true;
+					m_Queued.notify_one();
+				}
+				m_Thread.join();
+			}
+
+		public:
+
+			/// <summary>The buffer size and buffer count used when none are specified.</summary>
+			static const UInt32 DefaultBufferSize = 1048576;			// 1MB
+			static const UInt32 DefaultBufferCount = 8;
+
+			/// <summary>Constructs a WriteBehindStream that writes to Base, beginning at its current position.</summary>
+			WriteBehindStream(memory::r_ptr<Stream>&& Base, UInt32 BufferSize = DefaultBufferSize, UInt32 BufferCount = DefaultBufferCount)
+				: m_pBase(std::move(Base))
+			{
+				m_BufferSize = (BufferSize > 0) ? BufferSize : 1;
+				m_nBuffers = (BufferCount > 1) ? BufferCount : 2;
+				m_Storage.Alloc((UInt64)m_BufferSize * m_nBuffers);
+				m_Fill.resize(m_nBuffers, 0);
+				m_iFront = m_nQueued = 0;
+				m_Stop = false;
+				m_iCurrent = 0;
+				m_pCurrent = GetBuffer(0);
+				m_nWrite = 0;
+				m_Position = m_pBase->CanSeek() ? m_pBase->GetPosition() : 0;
+				m_Thread = std::thread(&WriteBehindStream::WriteBehind, this);
+			}
+
+			WriteBehindStream(const WriteBehindStream& /*cp*/) { throw Exception("Cannot copy a WriteBehindStream object."); }
+			WriteBehindStream& operator=(const WriteBehindStream& /*cp*/) { throw Exception("Cannot copy a WriteBehindStream object."); }
+
+			~WriteBehindStream()
+			{
+				// The base stream is not closed here, as it may be owned elsewhere, but all pending writes must reach it.  Errors
+				// cannot be reported from a destructor; call Flush() or Close() first to observe them.
+				if (m_Thread.joinable())
+				{
+					try { Drain(); } catch (...) { }
+					StopWriteBehind();
+				}
+			}
+
+			bool CanRead() override { return false; }
+			bool CanWrite() override { return true; }
+			bool CanSeek() override { return m_pBase->CanSeek(); }
+
+			void WriteByte(byte ch) override
+			{
+				if (m_nWrite >= (Int64)m_BufferSize) HandOver();
+				m_pCurrent[m_nWrite++] = ch;
+				m_Position ++;
+			}
+
+			void Write(const void *pBuffer, Int64 nLength) override
+			{
+				const byte* pSrc = (const byte*)pBuffer;
+				while (nLength > 0)
+				{
+					if (m_nWrite >= (Int64)m_BufferSize) HandOver();
+					Int64 nCopy = m_BufferSize - m_nWrite;
+					if (nCopy > nLength) nCopy = nLength;
+					CopyMemory(m_pCurrent + m_nWrite, pSrc, (size_t)nCopy);
+					m_nWrite += nCopy;
+					m_Position += nCopy;
+					pSrc += nCopy;
+					nLength -= nCopy;
+				}
+			}
+
+			Int64 GetPosition() const override { return m_Position; }
+
+			Int64 GetLength() const override
+			{
+				WriteBehindStream* pThis = const_cast<WriteBehindStream*>(this);
+				pThis->Drain();
+				return m_pBase->GetLength();
+			}
+
+			void Seek(Int64 offset, SeekOrigin origin) override
+			{
+				Drain();
+				m_pBase->Seek(offset, origin);
+				m_Position = m_pBase->GetPosition();
+			}
+
+			/// <summary>Waits until all data written so far has been passed to the underlying stream, and then flushes the underlying
+			/// stream.</summary>
+			void Flush() override
+			{
+				Drain();
+				m_pBase->Flush();
+			}
+
+			void Close() override
+			{
+				if (m_Thread.joinable())
+				{
+					try { Drain(); m_pBase->Flush(); }
+					catch (...) { StopWriteBehind(); throw; }
+					StopWriteBehind();
+				}
+				if (m_pBase.IsAssigned()) m_pBase->Close();
+			}
+		};
+	}
+}
+
+#endif	// UseSTL
+
+#endif	// __WBWriteBehindStream_h__
+
+//	End of WriteBehindStream.h
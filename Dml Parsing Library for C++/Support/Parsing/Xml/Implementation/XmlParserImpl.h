@@ -42,6 +42,7 @@ namespace wb
 		{
 			// Optimization: Could avoid storing the whole thing in memory and parse as we go...
 			wb::io::MemoryStream ms;
+			if (stream.CanSeek()) ms.EnsureCapacity(stream.GetLength() - stream.GetPosition() + 1);		// Avoid regrowing the copy.
 			wb::io::StreamToStream(stream, ms);
 			ms.Seek(0, wb::io::SeekOrigin::End);
 			ms.WriteByte(0);			// Add null-terminator
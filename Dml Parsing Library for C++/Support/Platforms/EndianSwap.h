@@ -0,0 +1,183 @@
+/*	EndianSwap.h
+	Copyright (C) 2014 by Wiley Black (TheWiley@gmail.com)
+*/
+
+#ifndef __WBEndianSwap_h__
+#define __WBEndianSwap_h__
+
+#include "Platforms.h"
+#include "../Exceptions.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define EndianSwap_x86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+#if defined(EndianSwap_x86) && !defined(_MSC_VER)
+#define EndianSwap_Target(x)	__attribute__((target(x)))
+#else
+#define EndianSwap_Target(x)
+#endif
+
+namespace wb
+{
+	namespace endian_swap
+	{
+		/** Scalar kernels.  These handle unaligned data and the tail of the vectorized kernels. **/
+
+		inline void Swap16_Scalar(byte* pDst, const byte* pSrc, size_t nElements)
+		{
+			for (size_t ii = 0; ii < nElements; ii++, pDst += 2, pSrc += 2)
+			{
+				byte a = pSrc[0], b = pSrc[1];
+				pDst[0] = b; pDst[1] = a;
+			}
+		}
+
+		inline void Swap32_Scalar(byte* pDst, const byte* pSrc, size_t nElements)
+		{
+			for (size_t ii = 0; ii < nElements; ii++, pDst += 4, pSrc += 4)
+			{
+				byte a = pSrc[0], b = pSrc[1], c = pSrc[2], d = pSrc[3];
+				pDst[0] = d; pDst[1] = c; pDst[2] = b; pDst[3] = a;
+			}
+		}
+
+		inline void Swap64_Scalar(byte* pDst, const byte* pSrc, size_t nElements)
+		{
+			for (size_t ii = 0; ii < nElements; ii++, pDst += 8, pSrc += 8)
+			{
+				UInt64 Value;
+				CopyMemory(&Value, pSrc, 8);
+				Value = SwapEndian(Value);
+				CopyMemory(pDst, &Value, 8);
+			}
+		}
+
+		typedef void (*SwapKernel)(byte* pDst, const byte* pSrc, size_t nElements);
+
+		#if defined(EndianSwap_x86)
+
+		/** SSSE3 and AVX2 kernels.  Each element lies entirely within a 16-byte lane, so a single in-lane byte shuffle reverses
+			every element in a vector.  Unaligned loads and stores are used throughout. **/
+
+		#define EndianSwap_Mask2	14,15,12,13,10,11,8,9,6,7,4,5,2,3,0,1
+		#define EndianSwap_Mask4	12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3
+		#define EndianSwap_Mask8	8,9,10,11,12,13,14,15,0,1,2,3,4,5,6,7
+
+		template<int ElementSize> EndianSwap_Target("ssse3") inline void Swap_SSSE3(byte* pDst, const byte* pSrc, size_t nElements, __m128i Mask)
+		{
+			size_t nBytes = nElements * ElementSize;
+			size_t ii = 0;
+			for (; ii + 16 <= nBytes; ii += 16)
+			{
+				__m128i v = _mm_loadu_si128((const __m128i*)(pSrc + ii));
+				_mm_storeu_si128((__m128i*)(pDst + ii), _mm_shuffle_epi8(v, Mask));
+			}
+			switch (ElementSize)
+			{
+			case 2: Swap16_Scalar(pDst + ii, pSrc + ii, (nBytes - ii) / 2); break;
+			case 4: Swap32_Scalar(pDst + ii, pSrc + ii, (nBytes - ii) / 4); break;
+			case 8: Swap64_Scalar(pDst + ii, pSrc + ii, (nBytes - ii) / 8); break;
+			}
+		}
+
+		template<int ElementSize> EndianSwap_Target("avx2") inline void Swap_AVX2(byte* pDst, const byte* pSrc, size_t nElements, __m256i Mask)
+		{
+			size_t nBytes = nElements * ElementSize;
+			size_t ii = 0;
+			for (; ii + 32 <= nBytes; ii += 32)
+			{
+				__m256i v = _mm256_loadu_si256((const __m256i*)(pSrc + ii));
+				_mm256_storeu_si256((__m256i*)(pDst + ii), _mm256_shuffle_epi8(v, Mask));
+			}
+			switch (ElementSize)
+			{
+			case 2: Swap16_Scalar(pDst + ii, pSrc + ii, (nBytes - ii) / 2); break;
+			case 4: Swap32_Scalar(pDst + ii, pSrc + ii, (nBytes - ii) / 4); break;
+			case 8: Swap64_Scalar(pDst + ii, pSrc + ii, (nBytes - ii) / 8); break;
+			}
+		}
+
+		// The shuffle masks are listed from the high byte down, as _mm_set_epi8() expects, and select the reversed byte
+		// position within each element.
+		EndianSwap_Target("ssse3") inline void Swap16_SSSE3(byte* pDst, const byte* pSrc, size_t n) { Swap_SSSE3<2>(pDst, pSrc, n, _mm_set_epi8(EndianSwap_Mask2)); }
+		EndianSwap_Target("ssse3") inline void Swap32_SSSE3(byte* pDst, const byte* pSrc, size_t n) { Swap_SSSE3<4>(pDst, pSrc, n, _mm_set_epi8(EndianSwap_Mask4)); }
+		EndianSwap_Target("ssse3") inline void Swap64_SSSE3(byte* pDst, const byte* pSrc, size_t n) { Swap_SSSE3<8>(pDst, pSrc, n, _mm_set_epi8(EndianSwap_Mask8)); }
+		EndianSwap_Target("avx2") inline void Swap16_AVX2(byte* pDst, const byte* pSrc, size_t n) { Swap_AVX2<2>(pDst, pSrc, n, _mm256_set_epi8(EndianSwap_Mask2, EndianSwap_Mask2)); }
+		EndianSwap_Target("avx2") inline void Swap32_AVX2(byte* pDst, const byte* pSrc, size_t n) { Swap_AVX2<4>(pDst, pSrc, n, _mm256_set_epi8(EndianSwap_Mask4, EndianSwap_Mask4)); }
+		EndianSwap_Target("avx2") inline void Swap64_AVX2(byte* pDst, const byte* pSrc, size_t n) { Swap_AVX2<8>(pDst, pSrc, n, _mm256_set_epi8(EndianSwap_Mask8, EndianSwap_Mask8)); }
+
+		inline bool HasSSSE3()
+		{
+			#if defined(_MSC_VER)
+			int Info[4];
+			__cpuid(Info, 1);
+			return (Info[2] & (1 << 9)) != 0;
+			#else
+			return __builtin_cpu_supports("ssse3") != 0;
+			#endif
+		}
+
+		inline bool HasAVX2()
+		{
+			#if defined(_MSC_VER)
+			int Info[4];
+			__cpuid(Info, 0);
+			if (Info[0] < 7) return false;
+			__cpuid(Info, 1);
+			bool OSXSAVE = (Info[2] & (1 << 27)) != 0;
+			bool AVX = (Info[2] & (1 << 28)) != 0;
+			if (!OSXSAVE || !AVX) return false;
+			if ((_xgetbv(0) & 6) != 6) return false;			// The OS must preserve the YMM registers.
+			__cpuidex(Info, 7, 0);
+			return (Info[1] & (1 << 5)) != 0;
+			#else
+			return __builtin_cpu_supports("avx2") != 0;
+			#endif
+		}
+		#endif	// EndianSwap_x86
+
+		/// <summary>Kernels holds the swap routine for each element size, selected once for the processor that is running.</summary>
+		struct Kernels
+		{
+			SwapKernel Swap16;
+			SwapKernel Swap32;
+			SwapKernel Swap64;
+
+			Kernels()
+			{
+				Swap16 = Swap16_Scalar; Swap32 = Swap32_Scalar; Swap64 = Swap64_Scalar;
+				#if defined(EndianSwap_x86)
+				if (HasAVX2()) { Swap16 = Swap16_AVX2; Swap32 = Swap32_AVX2; Swap64 = Swap64_AVX2; }
+				else if (HasSSSE3()) { Swap16 = Swap16_SSSE3; Swap32 = Swap32_SSSE3; Swap64 = Swap64_SSSE3; }
+				#endif
+			}
+
+			static const Kernels& Get() { static Kernels Selected; return Selected; }
+		};
+	}
+
+	/// <summary>SwapEndianCopy() copies nElements values of ElementSize bytes each (2, 4, or 8) from pSrc to pDst, reversing the
+	/// byte order of each value.  The fastest routine available on the processor (AVX2, SSSE3, or scalar) is used.  pDst and pSrc
+	/// may be the same buffer to swap in place, but must not otherwise overlap.  Neither needs to be aligned.</summary>
+	inline void SwapEndianCopy(void* pDst, const void* pSrc, size_t nElements, size_t ElementSize)
+	{
+		const endian_swap::Kernels& k = endian_swap::Kernels::Get();
+		switch (ElementSize)
+		{
+		case 1: if (pDst != pSrc) MoveMemory(pDst, pSrc, nElements); return;
+		case 2: k.Swap16((byte*)pDst, (const byte*)pSrc, nElements); return;
+		case 4: k.Swap32((byte*)pDst, (const byte*)pSrc, nElements); return;
+		case 8: k.Swap64((byte*)pDst, (const byte*)pSrc, nElements); return;
+		default: throw ArgumentException(S("Unsupported element size for endian conversion."));
+		}
+	}
+}
+
+#endif	// __WBEndianSwap_h__
+
+//	End of EndianSwap.h